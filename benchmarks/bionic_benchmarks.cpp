@@ -19,6 +19,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <sys/resource.h>
+#include <time.h>
 
 #include <map>
 #include <mutex>
@@ -556,6 +557,13 @@ std::map<std::string, args_vector_t> GetShorthand() {
 
       {"MATH_COMMON", args_vector_t{{0}, {1}, {2}, {3}}},
       {"MATH_SINCOS_COMMON", args_vector_t{{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}}},
+
+      // Every clock, including the CPU-time clocks that the vdso doesn't handle,
+      // so any clock that silently falls back to the system call stands out.
+      {"CLOCK_IDS", args_vector_t{{CLOCK_REALTIME}, {CLOCK_MONOTONIC}, {CLOCK_PROCESS_CPUTIME_ID},
+                                  {CLOCK_THREAD_CPUTIME_ID}, {CLOCK_MONOTONIC_RAW},
+                                  {CLOCK_REALTIME_COARSE}, {CLOCK_MONOTONIC_COARSE},
+                                  {CLOCK_BOOTTIME}, {CLOCK_TAI}}},
   };
 
   args_vector_t args_onebuf;
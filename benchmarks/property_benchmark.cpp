@@ -153,6 +153,22 @@ static void BM_property_find(benchmark::State& state) {
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_property_find, "NUM_PROPS");
 
+// Repeatedly finds the same properties in order, as a process polling its
+// configuration would. Small working sets are served from the find cache.
+static void BM_property_find_repeated(benchmark::State& state) {
+  const size_t nprops = state.range(0);
+
+  LocalPropertyTestState pa(nprops);
+  if (!pa.valid) return;
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pa.system_properties().Find(pa.names[i]));
+    i = (i + 1) % nprops;
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_property_find_repeated, "NUM_PROPS");
+
 static void BM_property_read(benchmark::State& state) {
   const size_t nprops = state.range(0);
 
@@ -16,6 +16,9 @@
 
 #include <pthread.h>
 
+#include <atomic>
+#include <thread>
+
 #include <benchmark/benchmark.h>
 #include "util.h"
 
@@ -99,6 +102,18 @@ static void BM_pthread_mutex_lock_RECURSIVE(benchmark::State& state) {
 BIONIC_BENCHMARK(BM_pthread_mutex_lock_RECURSIVE);
 #endif
 
+#if !defined(ANDROID_HOST_MUSL)
+static void BM_pthread_mutex_lock_ADAPTIVE(benchmark::State& state) {
+  pthread_mutex_t mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+
+  while (state.KeepRunning()) {
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+}
+BIONIC_BENCHMARK(BM_pthread_mutex_lock_ADAPTIVE);
+#endif
+
 namespace {
 struct PIMutex {
   pthread_mutex_t mutex;
@@ -174,6 +189,78 @@ static void BM_pthread_rwlock_write(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_pthread_rwlock_write);
 
+// The contended benchmarks below take a lock around a short critical section while another
+// thread does the same in a loop, which is the case adaptive spinning is meant for.
+namespace {
+struct Contender {
+  std::atomic<bool> done{false};
+  std::thread thread;
+
+  template <typename Fn>
+  explicit Contender(Fn fn) : thread([this, fn]() {
+    while (!done) fn();
+  }) {}
+
+  ~Contender() {
+    done = true;
+    thread.join();
+  }
+};
+}
+
+static void ShortCriticalSection() {
+  for (int i = 0; i < 50; ++i) {
+    benchmark::DoNotOptimize(i);
+  }
+}
+
+static void MutexContended(benchmark::State& state, pthread_mutex_t* mutex) {
+  auto lock_and_unlock = [mutex]() {
+    pthread_mutex_lock(mutex);
+    ShortCriticalSection();
+    pthread_mutex_unlock(mutex);
+  };
+  Contender contender(lock_and_unlock);
+  while (state.KeepRunning()) {
+    lock_and_unlock();
+  }
+}
+
+static void BM_pthread_mutex_lock_contended(benchmark::State& state) {
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  MutexContended(state, &mutex);
+}
+BIONIC_BENCHMARK(BM_pthread_mutex_lock_contended);
+
+#if !defined(ANDROID_HOST_MUSL)
+static void BM_pthread_mutex_lock_ADAPTIVE_contended(benchmark::State& state) {
+  pthread_mutex_t mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  MutexContended(state, &mutex);
+}
+BIONIC_BENCHMARK(BM_pthread_mutex_lock_ADAPTIVE_contended);
+#endif
+
+// Set BIONIC_LOCK_SPIN_COUNT to compare with spinning rwlocks.
+static void BM_pthread_rwlock_write_contended(benchmark::State& state) {
+  pthread_rwlock_t lock;
+  pthread_rwlock_init(&lock, nullptr);
+
+  auto lock_and_unlock = [&lock]() {
+    pthread_rwlock_wrlock(&lock);
+    ShortCriticalSection();
+    pthread_rwlock_unlock(&lock);
+  };
+  {
+    Contender contender(lock_and_unlock);
+    while (state.KeepRunning()) {
+      lock_and_unlock();
+    }
+  }
+
+  pthread_rwlock_destroy(&lock);
+}
+BIONIC_BENCHMARK(BM_pthread_rwlock_write_contended);
+
 static void* IdleThread(void*) {
   return nullptr;
 }
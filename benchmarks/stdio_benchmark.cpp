@@ -197,6 +197,23 @@ static void BM_stdio_printf_d(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_stdio_printf_d);
 
+static void BM_stdio_printf_zu_x(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    char buf[BUFSIZ];
+    snprintf(buf, sizeof(buf), "read %zu bytes at offset %lx from fd %d", static_cast<size_t>(4096),
+             0x7fff0000ul, 3);
+  }
+}
+BIONIC_BENCHMARK(BM_stdio_printf_zu_x);
+
+static void BM_stdio_printf_width_d(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    char buf[BUFSIZ];
+    snprintf(buf, sizeof(buf), "this is a more typical error message with detail: %8d", 123456);
+  }
+}
+BIONIC_BENCHMARK(BM_stdio_printf_width_d);
+
 static void BM_stdio_printf_1$s(benchmark::State& state) {
   while (state.KeepRunning()) {
     char buf[BUFSIZ];
@@ -235,6 +235,14 @@ BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtol, strtol(" -123", nullptr, 0));
 BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoll, strtoll(" -123", nullptr, 0));
 BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoul, strtoul(" -123", nullptr, 0));
 BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoull, strtoull(" -123", nullptr, 0));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoll_long, strtoll("-9223372036854775807", nullptr, 10));
 
 BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtol_hex, strtol("0xdeadbeef", nullptr, 0));
 BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoul_hex, strtoul("0xdeadbeef", nullptr, 0));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtoull_hex_long, strtoull("0xfedcba9876543210", nullptr, 16));
+
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_atof, atof(" -1.25"));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtod, strtod("3.141592653589793", nullptr));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtod_exp, strtod("-6.02214076e23", nullptr));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtod_slow, strtod("2.22507385850720129978001e-308", nullptr));
+BIONIC_TRIVIAL_BENCHMARK(BM_stdlib_strtof, strtof("3.1415927", nullptr));
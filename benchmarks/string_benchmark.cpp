@@ -292,6 +292,76 @@ static void BM_string_strstr(benchmark::State& state) {
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_string_strstr, "AT_ALIGNED_TWOBUF");
 
+// Fills the buffer with logcat-style lines, the kind of haystack that
+// substring searches mostly see in practice, and NUL-terminates it.
+static void FillWithLogLines(char* buf, size_t nbytes) {
+  static const char kLine[] =
+      "10-19 12:34:56.789  1234  5678 I ActivityManager: Start proc 4321:com.example.app/u0a123 "
+      "for service {com.example.app/.SyncService}\n";
+  for (size_t i = 0; i < nbytes; ++i) {
+    buf[i] = kLine[i % (sizeof(kLine) - 1)];
+  }
+  buf[nbytes - 1] = '\0';
+}
+
+// These look for a needle that isn't there, so every byte of the haystack
+// is searched.
+static constexpr char kMissingNeedle[] = "Connection: close";
+
+static void BM_string_memmem(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtr(&haystack, haystack_alignment, nbytes);
+  FillWithLogLines(haystack_aligned, nbytes);
+
+  while (state.KeepRunning()) {
+    if (memmem(haystack_aligned, nbytes, kMissingNeedle, sizeof(kMissingNeedle) - 1) != nullptr) {
+      errx(1, "ERROR: memmem found a substring where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_memmem, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strstr_log(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtr(&haystack, haystack_alignment, nbytes);
+  FillWithLogLines(haystack_aligned, nbytes);
+
+  while (state.KeepRunning()) {
+    if (strstr(haystack_aligned, kMissingNeedle) != nullptr) {
+      errx(1, "ERROR: strstr found a substring where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strstr_log, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strcasestr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtr(&haystack, haystack_alignment, nbytes);
+  FillWithLogLines(haystack_aligned, nbytes);
+
+  while (state.KeepRunning()) {
+    if (strcasestr(haystack_aligned, kMissingNeedle) != nullptr) {
+      errx(1, "ERROR: strcasestr found a substring where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strcasestr, "AT_ALIGNED_ONEBUF");
+
 static void BM_string_strchr(benchmark::State& state) {
   const size_t nbytes = state.range(0);
   const size_t haystack_alignment = state.range(1);
@@ -309,3 +379,39 @@ static void BM_string_strchr(benchmark::State& state) {
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_string_strchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strspn(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, ' ');
+  haystack_aligned[nbytes - 1] = '\0';
+
+  while (state.KeepRunning()) {
+    if (strspn(haystack_aligned, " \t\r\n") != nbytes - 1) {
+      errx(1, "ERROR: strspn returned the wrong length.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strspn, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strcspn(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'x');
+  haystack_aligned[nbytes - 1] = '\0';
+
+  while (state.KeepRunning()) {
+    if (strcspn(haystack_aligned, ":;\r\n") != nbytes - 1) {
+      errx(1, "ERROR: strcspn returned the wrong length.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strcspn, "AT_ALIGNED_ONEBUF");
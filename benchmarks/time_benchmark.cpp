@@ -100,6 +100,63 @@ static void BM_time_clock_gettime_BOOTTIME(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_time_clock_gettime_BOOTTIME);
 
+static const char* ClockName(int clock_id) {
+  switch (clock_id) {
+    case CLOCK_REALTIME: return "REALTIME";
+    case CLOCK_MONOTONIC: return "MONOTONIC";
+    case CLOCK_PROCESS_CPUTIME_ID: return "PROCESS_CPUTIME_ID";
+    case CLOCK_THREAD_CPUTIME_ID: return "THREAD_CPUTIME_ID";
+    case CLOCK_MONOTONIC_RAW: return "MONOTONIC_RAW";
+    case CLOCK_REALTIME_COARSE: return "REALTIME_COARSE";
+    case CLOCK_MONOTONIC_COARSE: return "MONOTONIC_COARSE";
+    case CLOCK_BOOTTIME: return "BOOTTIME";
+    case CLOCK_TAI: return "TAI";
+  }
+  return "?";
+}
+
+// The libc and system call versions of each clock side by side: the libc
+// version should be several times faster for every clock the vdso handles.
+static void BM_time_clock_gettime_clock(benchmark::State& state) {
+  clockid_t clock_id = state.range(0);
+  timespec t;
+  while (state.KeepRunning()) {
+    clock_gettime(clock_id, &t);
+  }
+  state.SetLabel(ClockName(clock_id));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_time_clock_gettime_clock, "CLOCK_IDS");
+
+static void BM_time_clock_gettime_clock_syscall(benchmark::State& state) {
+  clockid_t clock_id = state.range(0);
+  timespec t;
+  while (state.KeepRunning()) {
+    syscall(__NR_clock_gettime, clock_id, &t);
+  }
+  state.SetLabel(ClockName(clock_id));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_time_clock_gettime_clock_syscall, "CLOCK_IDS");
+
+static void BM_time_clock_getres_clock(benchmark::State& state) {
+  clockid_t clock_id = state.range(0);
+  timespec t;
+  while (state.KeepRunning()) {
+    clock_getres(clock_id, &t);
+  }
+  state.SetLabel(ClockName(clock_id));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_time_clock_getres_clock, "CLOCK_IDS");
+
+static void BM_time_clock_getres_clock_syscall(benchmark::State& state) {
+  clockid_t clock_id = state.range(0);
+  timespec t;
+  while (state.KeepRunning()) {
+    syscall(__NR_clock_getres, clock_id, &t);
+  }
+  state.SetLabel(ClockName(clock_id));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_time_clock_getres_clock_syscall, "CLOCK_IDS");
+
 static void BM_time_clock_getres(benchmark::State& state) {
   // CLOCK_MONOTONIC is required supported in vdso
   timespec t;
@@ -212,3 +269,14 @@ void BM_time_strftime(benchmark::State& state) {
   }
 }
 BIONIC_BENCHMARK(BM_time_strftime);
+
+// The timestamp in the common log format used by web servers.
+void BM_time_strftime_log(benchmark::State& state) {
+  char buf[128];
+  time_t t = 0;
+  struct tm* tm = gmtime(&t);
+  while (state.KeepRunning()) {
+    strftime(buf, sizeof(buf), "%d/%b/%Y:%H:%M:%S %z", tm);
+  }
+}
+BIONIC_BENCHMARK(BM_time_strftime_log);
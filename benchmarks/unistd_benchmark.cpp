@@ -15,8 +15,12 @@
  */
 
 #include <errno.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/syscall.h>
+#if defined(__riscv)
+#include <sys/hwprobe.h>
+#endif
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -36,6 +40,28 @@ BIONIC_TRIVIAL_BENCHMARK(BM_unistd_gettid, gettid());
 #endif
 BIONIC_TRIVIAL_BENCHMARK(BM_unistd_gettid_syscall, syscall(__NR_gettid));
 
+BIONIC_TRIVIAL_BENCHMARK(BM_unistd_sched_getcpu, sched_getcpu());
+BIONIC_TRIVIAL_BENCHMARK(BM_unistd_sched_getcpu_syscall,
+                         syscall(__NR_getcpu, nullptr, nullptr, nullptr));
+
+#if defined(__riscv)
+static void BM_unistd_riscv_hwprobe(benchmark::State& state) {
+  riscv_hwprobe probe = {.key = RISCV_HWPROBE_KEY_IMA_EXT_0};
+  while (state.KeepRunning()) {
+    __riscv_hwprobe(&probe, 1, 0, nullptr, 0);
+  }
+}
+BIONIC_BENCHMARK(BM_unistd_riscv_hwprobe);
+
+static void BM_unistd_riscv_hwprobe_syscall(benchmark::State& state) {
+  riscv_hwprobe probe = {.key = RISCV_HWPROBE_KEY_IMA_EXT_0};
+  while (state.KeepRunning()) {
+    syscall(__NR_riscv_hwprobe, &probe, 1, 0, nullptr, 0);
+  }
+}
+BIONIC_BENCHMARK(BM_unistd_riscv_hwprobe_syscall);
+#endif
+
 // Many native allocators have custom prefork and postfork functions.
 // Measure the fork call to make sure nothing takes too long.
 void BM_unistd_fork_call(benchmark::State& state) {
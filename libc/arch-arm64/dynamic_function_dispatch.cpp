@@ -166,4 +166,33 @@ DEFINE_IFUNC_FOR(strrchr) {
     }
 }
 
+typedef wchar_t* wcschr_func(const wchar_t*, wchar_t);
+DEFINE_IFUNC_FOR(wcschr) {
+    // TODO: enable an SVE version.
+    RETURN_FUNC(wcschr_func, __wcschr_aarch64);
+}
+
+typedef int wcscmp_func(const wchar_t*, const wchar_t*);
+DEFINE_IFUNC_FOR(wcscmp) {
+    // TODO: enable an SVE version.
+    RETURN_FUNC(wcscmp_func, __wcscmp_aarch64);
+}
+
+typedef size_t wcslen_func(const wchar_t*);
+DEFINE_IFUNC_FOR(wcslen) {
+    // TODO: enable an SVE version.
+    RETURN_FUNC(wcslen_func, __wcslen_aarch64);
+}
+
+typedef wchar_t* wmemchr_func(const wchar_t*, wchar_t, size_t);
+DEFINE_IFUNC_FOR(wmemchr) {
+    // TODO: enable an SVE version.
+    RETURN_FUNC(wmemchr_func, __wmemchr_aarch64);
+}
+
+typedef wchar_t* wmemset_func(wchar_t*, wchar_t, size_t);
+DEFINE_IFUNC_FOR(wmemset) {
+    RETURN_FUNC(wmemset_func, __wmemset_aarch64);
+}
+
 }  // extern "C"
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cpuid.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private/bionic_globals.h"
+
+#include "arch-x86_64/string/cache.h"
+
+// The string routines read these directly (see cache.h). They start out
+// with the old compile-time values so that anything copied before
+// __libc_init_cache_info() runs still takes a sensible path.
+__LIBC_HIDDEN__ size_t __x86_64_data_cache_size = DEFAULT_DATA_CACHE_SIZE;
+__LIBC_HIDDEN__ size_t __x86_64_data_cache_size_half = DEFAULT_DATA_CACHE_SIZE / 2;
+__LIBC_HIDDEN__ size_t __x86_64_shared_cache_size = DEFAULT_SHARED_CACHE_SIZE;
+__LIBC_HIDDEN__ size_t __x86_64_shared_cache_size_half = DEFAULT_SHARED_CACHE_SIZE / 2;
+__LIBC_HIDDEN__ size_t __x86_64_rep_movsb_threshold = DEFAULT_REP_MOVSB_THRESHOLD;
+
+// Intel's leaf 4 and AMD's leaf 0x8000001d describe one cache per subleaf,
+// in the same format, until they report a cache type of 0. The shared size
+// we report is one thread's share of the last-level cache, since that's how
+// much a copy can use without evicting everyone else's working set.
+static void read_cache_leaf(uint32_t leaf, size_t* data, size_t* shared) {
+  int shared_level = 0;
+  for (uint32_t i = 0; i < 16; ++i) {
+    uint32_t eax, ebx, ecx, edx;
+    __cpuid_count(leaf, i, eax, ebx, ecx, edx);
+    uint32_t type = eax & 0x1f;
+    if (type == 0) break;
+    int level = (eax >> 5) & 0x7;
+    size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+    size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+    size_t line_size = (ebx & 0xfff) + 1;
+    size_t sets = static_cast<size_t>(ecx) + 1;
+    size_t size = ways * partitions * line_size * sets;
+
+    if (level == 1 && type == 1) {
+      *data = size;
+    } else if (type == 3 && level > shared_level) {
+      // The last-level cache is the one we don't want a huge copy to evict.
+      size_t threads = ((eax >> 14) & 0xfff) + 1;
+      *shared = size / threads;
+      shared_level = level;
+    }
+  }
+}
+
+__LIBC_HIDDEN__ void __libc_init_cache_info() {
+  uint32_t eax, ebx, ecx, edx;
+  if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) == 0) return;
+  uint32_t max_leaf = eax;
+  bool is_amd = (ebx == signature_AMD_ebx && ecx == signature_AMD_ecx && edx == signature_AMD_edx);
+
+  size_t data = 0;
+  size_t shared = 0;
+  if (is_amd) {
+    // Leaf 0x8000001d is only there with the topology extensions (TOPOEXT).
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 22)) != 0) {
+      read_cache_leaf(0x8000001d, &data, &shared);
+    }
+  } else if (max_leaf >= 4) {
+    read_cache_leaf(4, &data, &shared);
+  }
+
+  // Hypervisors sometimes hide the cache leaves, in which case keep the defaults.
+  if (data != 0) {
+    __x86_64_data_cache_size = data;
+    __x86_64_data_cache_size_half = data / 2;
+  }
+  if (shared != 0) {
+    __x86_64_shared_cache_size = shared;
+    __x86_64_shared_cache_size_half = shared / 2;
+  }
+
+  // Without fast short `rep movsb` (FSRM), its startup cost only pays off
+  // for larger copies.
+  if (max_leaf >= 7) {
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if ((edx & (1 << 4)) == 0) __x86_64_rep_movsb_threshold = 2 * DEFAULT_REP_MOVSB_THRESHOLD;
+  }
+}
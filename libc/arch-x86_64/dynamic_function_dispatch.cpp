@@ -26,10 +26,17 @@
  * SUCH DAMAGE.
  */
 
+#include <cpuid.h>
 #include <stddef.h>
 
 #include <private/bionic_ifuncs.h>
 
+// __builtin_cpu_supports() doesn't know about ERMS (fast `rep movsb`).
+static bool have_erms() {
+  unsigned int eax, ebx, ecx, edx;
+  return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_ENH_MOVSB) != 0;
+}
+
 extern "C" {
 
 typedef int memset_func(void* __dst, int __ch, size_t __n);
@@ -46,4 +53,157 @@ DEFINE_IFUNC_FOR(__memset_chk) {
   RETURN_FUNC(__memset_chk_func, __memset_chk_generic);
 }
 
+typedef void* memcpy_func(void*, const void*, size_t);
+DEFINE_IFUNC_FOR(memcpy) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    if (have_erms()) RETURN_FUNC(memcpy_func, memcpy_avx2_erms);
+    RETURN_FUNC(memcpy_func, memcpy_avx2);
+  }
+  RETURN_FUNC(memcpy_func, memcpy_generic);
+}
+
+typedef void* memmove_func(void*, const void*, size_t);
+DEFINE_IFUNC_FOR(memmove) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    if (have_erms()) RETURN_FUNC(memmove_func, memmove_avx2_erms);
+    RETURN_FUNC(memmove_func, memmove_avx2);
+  }
+  RETURN_FUNC(memmove_func, memmove_generic);
+}
+
+typedef int memcmp_func(const void*, const void*, size_t);
+DEFINE_IFUNC_FOR(memcmp) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(memcmp_func, memcmp_avx2);
+  RETURN_FUNC(memcmp_func, memcmp_generic);
+}
+
+typedef void* memchr_func(const void*, int, size_t);
+DEFINE_IFUNC_FOR(memchr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(memchr_func, memchr_avx2);
+  RETURN_FUNC(memchr_func, memchr_generic);
+}
+
+typedef void* memrchr_func(const void*, int, size_t);
+DEFINE_IFUNC_FOR(memrchr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(memrchr_func, memrchr_avx2);
+  RETURN_FUNC(memrchr_func, memrchr_generic);
+}
+
+typedef size_t strlen_func(const char*);
+DEFINE_IFUNC_FOR(strlen) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strlen_func, strlen_avx2);
+  RETURN_FUNC(strlen_func, strlen_generic);
+}
+
+typedef char* strchr_func(const char*, int);
+DEFINE_IFUNC_FOR(strchr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strchr_func, strchr_avx2);
+  RETURN_FUNC(strchr_func, strchr_generic);
+}
+
+typedef char* strrchr_func(const char*, int);
+DEFINE_IFUNC_FOR(strrchr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strrchr_func, strrchr_avx2);
+  RETURN_FUNC(strrchr_func, strrchr_generic);
+}
+
+typedef int strcmp_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strcmp) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strcmp_func, strcmp_avx2);
+  RETURN_FUNC(strcmp_func, strcmp_generic);
+}
+
+typedef int strncmp_func(const char*, const char*, size_t);
+DEFINE_IFUNC_FOR(strncmp) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strncmp_func, strncmp_avx2);
+  RETURN_FUNC(strncmp_func, strncmp_generic);
+}
+
+typedef void* memmem_func(const void*, size_t, const void*, size_t);
+DEFINE_IFUNC_FOR(memmem) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(memmem_func, memmem_avx2);
+  RETURN_FUNC(memmem_func, memmem_generic);
+}
+
+typedef char* strstr_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strstr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strstr_func, strstr_avx2);
+  RETURN_FUNC(strstr_func, strstr_generic);
+}
+
+typedef char* strcasestr_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strcasestr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strcasestr_func, strcasestr_avx2);
+  RETURN_FUNC(strcasestr_func, strcasestr_generic);
+}
+
+typedef size_t strspn_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strspn) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strspn_func, strspn_avx2);
+  RETURN_FUNC(strspn_func, strspn_generic);
+}
+
+typedef size_t strcspn_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strcspn) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strcspn_func, strcspn_avx2);
+  RETURN_FUNC(strcspn_func, strcspn_generic);
+}
+
+typedef char* strpbrk_func(const char*, const char*);
+DEFINE_IFUNC_FOR(strpbrk) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(strpbrk_func, strpbrk_avx2);
+  RETURN_FUNC(strpbrk_func, strpbrk_generic);
+}
+
+typedef wchar_t* wcschr_func(const wchar_t*, wchar_t);
+DEFINE_IFUNC_FOR(wcschr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(wcschr_func, wcschr_avx2);
+  RETURN_FUNC(wcschr_func, wcschr_generic);
+}
+
+typedef int wcscmp_func(const wchar_t*, const wchar_t*);
+DEFINE_IFUNC_FOR(wcscmp) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(wcscmp_func, wcscmp_avx2);
+  RETURN_FUNC(wcscmp_func, wcscmp_generic);
+}
+
+typedef size_t wcslen_func(const wchar_t*);
+DEFINE_IFUNC_FOR(wcslen) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(wcslen_func, wcslen_avx2);
+  RETURN_FUNC(wcslen_func, wcslen_generic);
+}
+
+typedef wchar_t* wmemchr_func(const wchar_t*, wchar_t, size_t);
+DEFINE_IFUNC_FOR(wmemchr) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(wmemchr_func, wmemchr_avx2);
+  RETURN_FUNC(wmemchr_func, wmemchr_generic);
+}
+
+typedef wchar_t* wmemset_func(wchar_t*, wchar_t, size_t);
+DEFINE_IFUNC_FOR(wmemset) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(wmemset_func, wmemset_avx2);
+  RETURN_FUNC(wmemset_func, wmemset_generic);
+}
+
 }  // extern "C"
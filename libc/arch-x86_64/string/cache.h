@@ -28,9 +28,12 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-/* Values are optimized for Core Architecture */
-#define SHARED_CACHE_SIZE (4096*1024)  /* Core Architecture L2 Cache */
-#define DATA_CACHE_SIZE   (24*1024)    /* Core Architecture L1 Data Cache */
+/* Values are optimized for Core Architecture. These are only the defaults
+   for the __x86_64_*_cache_size* variables that the string routines read:
+   __libc_init_cache_info() replaces them with what CPUID reports. */
+#define DEFAULT_SHARED_CACHE_SIZE (4096*1024)  /* Core Architecture L2 Cache */
+#define DEFAULT_DATA_CACHE_SIZE   (24*1024)    /* Core Architecture L1 Data Cache */
 
-#define SHARED_CACHE_SIZE_HALF (SHARED_CACHE_SIZE / 2)
-#define DATA_CACHE_SIZE_HALF   (DATA_CACHE_SIZE / 2)
+/* Above this size, `rep movsb` beats the vector loops on CPUs with ERMS.
+   __libc_init_cache_info() doubles it for CPUs without FSRM. */
+#define DEFAULT_REP_MOVSB_THRESHOLD 2048
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <immintrin.h>
+#include <string.h>
+
+// Compile the shared substring search (and everything else in this file)
+// for AVX2. The header has to come after this, or the StringSearch
+// functions wouldn't be able to inline the operations below.
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+
+#include "private/bionic_string_search.h"
+
+struct Avx2SearchOps {
+  typedef __m256i V;
+  static constexpr size_t kBlock = 32;
+  static constexpr int kShift = 0;
+
+  static V Splat(uint8_t c) { return _mm256_set1_epi8(c); }
+  static V Load(const uint8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+  static V Equal(V a, V b) { return _mm256_cmpeq_epi8(a, b); }
+  static V And(V a, V b) { return _mm256_and_si256(a, b); }
+  static V Or(V a, V b) { return _mm256_or_si256(a, b); }
+  static uint64_t ToMask(V v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+};
+
+extern "C" void* memmem_avx2(const void* haystack, size_t haystack_size, const void* needle,
+                             size_t needle_size) {
+  return StringSearch<Avx2SearchOps>::Memmem(haystack, haystack_size, needle, needle_size);
+}
+
+extern "C" char* strstr_avx2(const char* haystack, const char* needle) {
+  return StringSearch<Avx2SearchOps>::Strstr(haystack, needle);
+}
+
+extern "C" char* strcasestr_avx2(const char* haystack, const char* needle) {
+  return StringSearch<Avx2SearchOps>::Strcasestr(haystack, needle);
+}
+
+#pragma clang attribute pop
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010 The Android Open Source Project
+ * Copyright (C) 2024 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -26,16 +26,8 @@
  * SUCH DAMAGE.
  */
 
-#define _GNU_SOURCE 1
-#include <sched.h>
+#include <string.h>
 
-extern "C" int __getcpu(unsigned*, unsigned*, void*);
-
-int sched_getcpu() {
-  unsigned cpu;
-  int rc = __getcpu(&cpu, nullptr, nullptr);
-  if (rc == -1) {
-    return -1; // errno is already set.
-  }
-  return cpu;
+extern "C" char* strchr_generic(const char* p, int ch) {
+  return __strchr_chk(p, ch, __BIONIC_FORTIFY_UNKNOWN_SIZE);
 }
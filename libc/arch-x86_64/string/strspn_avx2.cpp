@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <immintrin.h>
+#include <string.h>
+
+// As in memmem_avx2.cpp, the shared code has to be inside the AVX2 region.
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+
+#include "private/bionic_byte_set.h"
+
+// vpshufb shuffles each 128-bit lane separately, so the tables are
+// duplicated into both lanes.
+struct Avx2ByteSetOps {
+  typedef __m256i V;
+  static constexpr size_t kBlock = 32;
+  static constexpr int kShift = 0;
+
+  static V Splat(uint8_t c) { return _mm256_set1_epi8(c); }
+  static V Load(const uint8_t* p) { return _mm256_load_si256(reinterpret_cast<const V*>(p)); }
+  static V LoadTable(const uint8_t* table) {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+  }
+  static V Shuffle(V table, V index) { return _mm256_shuffle_epi8(table, index); }
+  static V HighNibbles(V v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0xf));
+  }
+  static V Equal(V a, V b) { return _mm256_cmpeq_epi8(a, b); }
+  static V And(V a, V b) { return _mm256_and_si256(a, b); }
+  static V Or(V a, V b) { return _mm256_or_si256(a, b); }
+  static V Xor(V a, V b) { return _mm256_xor_si256(a, b); }
+  static uint64_t ToMask(V v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+};
+
+extern "C" size_t strspn_avx2(const char* s, const char* accept) {
+  return ByteSetSearch<Avx2ByteSetOps>::Strspn(s, accept);
+}
+
+extern "C" size_t strcspn_avx2(const char* s, const char* reject) {
+  return ByteSetSearch<Avx2ByteSetOps>::Strcspn(s, reject);
+}
+
+extern "C" char* strpbrk_avx2(const char* s, const char* accept) {
+  return ByteSetSearch<Avx2ByteSetOps>::Strpbrk(s, accept);
+}
+
+#pragma clang attribute pop
@@ -35,11 +35,20 @@
 #include "pthread_internal.h"
 
 #include "private/bionic_defs.h"
+#include "private/thread_private.h"
 #include "platform/bionic/macros.h"
 
 extern "C" pid_t __bionic_clone(uint32_t flags, void* child_stack, int* parent_tid, void* tls, int* child_tid, int (*fn)(void*), void* arg);
 extern "C" __noreturn void __exit(int status);
 
+#if defined(__ANDROID_NATIVE_BRIDGE__)
+// The native bridge may replace pthread_create() and clone() with versions
+// that never set this, so never elide locks there.
+bool __libc_multi_threaded = true;
+#else
+bool __libc_multi_threaded = false;
+#endif
+
 // Called from the __bionic_clone assembler to call the thread function then exit.
 __attribute__((no_sanitize("hwaddress")))
 extern "C" __LIBC_HIDDEN__ void __start_thread(int (*fn)(void*), void* arg) {
@@ -97,6 +106,15 @@ int clone(int (*fn)(void*), void* child_stack, int flags, void* arg, ...) {
     self->tid = -1;
   }
 
+  // pthread_create() comes through here, as does anyone making their own
+  // threads. A child sharing our address space (other than a vfork child,
+  // which runs while we're suspended) means stdio has to start locking. This
+  // must be visible before the child can run. Only write it once, so later
+  // calls don't race with the stdio readers.
+  if ((flags & (CLONE_VM|CLONE_VFORK)) == CLONE_VM && !__libc_multi_threaded) {
+    __libc_multi_threaded = true;
+  }
+
   // Actually do the clone.
   int clone_result;
   if (fn != nullptr) {
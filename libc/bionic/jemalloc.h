@@ -35,6 +35,7 @@ struct mallinfo je_mallinfo();
 void je_malloc_disable();
 void je_malloc_enable();
 int je_malloc_info(int options, FILE* fp);
+size_t je_malloc_purgeable_bytes();
 int je_mallopt(int, int);
 void* je_memalign_round_up_boundary(size_t, size_t);
 void* je_pvalloc(size_t);
@@ -16,6 +16,7 @@
 
 #include <errno.h>
 #include <malloc.h>
+#include <stdint.h>
 #include <sys/param.h>
 #include <unistd.h>
 
@@ -161,6 +162,43 @@ int je_mallopt(int param, int value) {
   return 0;
 }
 
+// Returns the bytes of dirty and muzzy pages, which are free but still
+// resident and are what "arena.<i>.purge" releases, or SIZE_MAX on error.
+size_t je_malloc_purgeable_bytes() {
+  // The stats are only updated when the epoch is advanced.
+  uint64_t epoch = 1;
+  size_t sz = sizeof(epoch);
+  if (je_mallctl("epoch", &epoch, &sz, &epoch, sz) != 0) {
+    return SIZE_MAX;
+  }
+
+  size_t page_size;
+  sz = sizeof(page_size);
+  if (je_mallctl("arenas.page", &page_size, &sz, nullptr, 0) != 0) {
+    return SIZE_MAX;
+  }
+  unsigned narenas;
+  sz = sizeof(unsigned);
+  if (je_mallctl("arenas.narenas", &narenas, &sz, nullptr, 0) != 0) {
+    return SIZE_MAX;
+  }
+
+  // As for "arena.<i>.purge", an index of narenas means all of the arenas.
+  const char* stats[] = {"pdirty", "pmuzzy"};
+  size_t pages = 0;
+  for (const char* stat : stats) {
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), "stats.arenas.%u.%s", narenas, stat);
+    size_t n;
+    sz = sizeof(n);
+    if (je_mallctl(buffer, &n, &sz, nullptr, 0) != 0) {
+      return SIZE_MAX;
+    }
+    pages += n;
+  }
+  return pages * page_size;
+}
+
 int je_malloc_info(int options, FILE* fp) {
   if (options != 0) {
     errno = EINVAL;
@@ -168,6 +168,11 @@ void __libc_init_common() {
 #endif
 
   __libc_add_main_thread();
+  __pthread_init_lock_spin_counts(); // Requires 'environ'.
+
+#if defined(__x86_64__)
+  __libc_init_cache_info();
+#endif
 
   __system_properties_init(); // Requires 'environ'.
   __libc_init_fdsan(); // Requires system properties (for debug.fdsan).
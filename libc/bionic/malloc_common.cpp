@@ -47,6 +47,7 @@
 #include "heap_zero_init.h"
 #include "malloc_common.h"
 #include "malloc_limit.h"
+#include "malloc_purge.h"
 #include "malloc_tagged_pointers.h"
 
 // =============================================================================
@@ -364,6 +365,9 @@ extern "C" bool android_mallopt(int opcode, void* arg, size_t arg_size) {
     *reinterpret_cast<bool*>(arg) = atomic_load(&__libc_globals->decay_time_enabled);
     return true;
   }
+  if (opcode == M_SET_BACKGROUND_PURGE_TARGET) {
+    return SetBackgroundPurgeTarget(arg, arg_size);
+  }
   errno = ENOTSUP;
   return false;
 }
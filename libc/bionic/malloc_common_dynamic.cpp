@@ -72,6 +72,7 @@
 #include "malloc_common_dynamic.h"
 #include "malloc_heapprofd.h"
 #include "malloc_limit.h"
+#include "malloc_purge.h"
 
 // =============================================================================
 // Global variables instantations.
@@ -553,6 +554,9 @@ extern "C" bool android_mallopt(int opcode, void* arg, size_t arg_size) {
     *reinterpret_cast<bool*>(arg) = atomic_load(&__libc_globals->decay_time_enabled);
     return true;
   }
+  if (opcode == M_SET_BACKGROUND_PURGE_TARGET) {
+    return SetBackgroundPurgeTarget(arg, arg_size);
+  }
   // Try heapprofd's mallopt, as it handles options not covered here.
   return HeapprofdMallopt(opcode, arg, arg_size);
 }
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "malloc_purge.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "malloc_common.h"
+
+// How often the purge thread samples the heap.
+static constexpr time_t kSampleIntervalSeconds = 1;
+
+// The heap counts as idle when the number of allocated bytes moved by less
+// than this between two consecutive samples. A busy heap is left alone so
+// that a purge never competes with the allocations it would have to undo.
+static constexpr size_t kIdleThresholdBytes = 64 * 1024;
+
+static pthread_mutex_t g_purge_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_purge_cond = PTHREAD_COND_INITIALIZER;
+
+// All of these are protected by g_purge_lock.
+static size_t g_purge_target_bytes = SIZE_MAX;
+static bool g_purge_thread_running = false;
+
+static pthread_once_t g_fork_handler_once = PTHREAD_ONCE_INIT;
+
+// A forked child doesn't inherit the purge thread, and the lock may have been
+// held by the parent's thread (or any other) at the time of the fork, so start
+// the child from scratch.
+static void PurgeForkChild() {
+  g_purge_lock = PTHREAD_MUTEX_INITIALIZER;
+  g_purge_cond = PTHREAD_COND_INITIALIZER;
+  g_purge_target_bytes = SIZE_MAX;
+  g_purge_thread_running = false;
+}
+
+// Returns how many bytes of freed memory the native allocator still holds that
+// M_PURGE would return to the kernel, or SIZE_MAX if it can't tell us.
+static size_t PurgeableBytes() {
+#if !__has_feature(hwaddress_sanitizer) && !defined(USE_SCUDO) && !defined(USE_SCUDO_SVELTE)
+  return je_malloc_purgeable_bytes();
+#else
+  return SIZE_MAX;
+#endif
+}
+
+static void* PurgeThread(void*) {
+  size_t last_allocated = 0;
+  // Whether the heap has changed since the last purge. Purging an
+  // untouched heap again would only burn cpu. Only used when the allocator
+  // can't tell us how much a purge would release.
+  bool dirty = true;
+
+  pthread_mutex_lock(&g_purge_lock);
+  while (g_purge_target_bytes != SIZE_MAX) {
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += kSampleIntervalSeconds;
+    pthread_cond_clockwait(&g_purge_cond, &g_purge_lock, CLOCK_MONOTONIC, &deadline);
+
+    size_t target_bytes = g_purge_target_bytes;
+    if (target_bytes == SIZE_MAX) {
+      break;
+    }
+    pthread_mutex_unlock(&g_purge_lock);
+
+    struct mallinfo info = mallinfo();
+    size_t allocated = info.uordblks;
+    size_t delta = (allocated > last_allocated) ? allocated - last_allocated
+                                                : last_allocated - allocated;
+    last_allocated = allocated;
+    if (delta != 0) {
+      dirty = true;
+    }
+    // Each step is a single incremental M_PURGE rather than M_PURGE_ALL, which
+    // bounds the cost of any one step by what the allocator considers cheap
+    // to release.
+    if (delta < kIdleThresholdBytes && dirty) {
+      size_t purgeable = PurgeableBytes();
+      if (purgeable == SIZE_MAX) {
+        // We can't compare against the target, so purge once each time the
+        // heap settles after changing.
+        mallopt(M_PURGE, 0);
+        dirty = false;
+      } else if (purgeable > target_bytes) {
+        mallopt(M_PURGE, 0);
+      }
+    }
+
+    pthread_mutex_lock(&g_purge_lock);
+  }
+  g_purge_thread_running = false;
+  pthread_mutex_unlock(&g_purge_lock);
+  return nullptr;
+}
+
+bool SetBackgroundPurgeTarget(void* arg, size_t arg_size) {
+  if (arg == nullptr || arg_size != sizeof(size_t)) {
+    errno = EINVAL;
+    return false;
+  }
+  size_t target_bytes = *reinterpret_cast<size_t*>(arg);
+
+  pthread_once(&g_fork_handler_once, [] { pthread_atfork(nullptr, nullptr, PurgeForkChild); });
+
+  pthread_mutex_lock(&g_purge_lock);
+  g_purge_target_bytes = target_bytes;
+  if (target_bytes == SIZE_MAX || g_purge_thread_running) {
+    // Either stopping, or the running thread will pick up the new target.
+    pthread_cond_signal(&g_purge_cond);
+    pthread_mutex_unlock(&g_purge_lock);
+    return true;
+  }
+
+  pthread_t thread_id;
+  int rc = pthread_create(&thread_id, nullptr, PurgeThread, nullptr);
+  if (rc != 0) {
+    g_purge_target_bytes = SIZE_MAX;
+    pthread_mutex_unlock(&g_purge_lock);
+    error_log("%s: malloc purge: failed to pthread_create", getprogname());
+    errno = rc;
+    return false;
+  }
+  g_purge_thread_running = true;
+  pthread_mutex_unlock(&g_purge_lock);
+
+  pthread_setname_np(thread_id, "mallocpurge");
+  pthread_detach(thread_id);
+  return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "private/bionic_string_search.h"
+
+#if defined(__x86_64__)
+// x86_64 chooses between these and the AVX2 versions at load time.
+#define MEMMEM memmem_generic
+#define STRSTR strstr_generic
+#else
+#define MEMMEM memmem
+#define STRSTR strstr
+#endif
+
+extern "C" void* MEMMEM(const void* haystack, size_t haystack_size, const void* needle,
+                        size_t needle_size) {
+  return StringSearch<DefaultSearchOps>::Memmem(haystack, haystack_size, needle, needle_size);
+}
+
+extern "C" char* STRSTR(const char* haystack, const char* needle) {
+  return StringSearch<DefaultSearchOps>::Strstr(haystack, needle);
+}
+
+// <string.h> declares strcasestr as a pair of extern "C++" overloads when
+// compiled as C++, so we can't define it directly here. Define it under
+// another name and alias it instead.
+extern "C" char* strcasestr_generic(const char* haystack, const char* needle) {
+  return StringSearch<DefaultSearchOps>::Strcasestr(haystack, needle);
+}
+#if !defined(__x86_64__)
+__strong_alias(strcasestr, strcasestr_generic);
+#endif
@@ -263,6 +263,41 @@ __LIBC_HIDDEN__ void pthread_key_clean_all(void);
 // Leave room for a guard page in the internally created signal stacks.
 #define SIGNAL_STACK_SIZE (SIGNAL_STACK_SIZE_WITHOUT_GUARD + PTHREAD_GUARD_SIZE)
 
+// The most iterations a contended PTHREAD_MUTEX_ADAPTIVE_NP mutex, or a contended rwlock, spins
+// before sleeping in the kernel. Rwlocks only spin if BIONIC_LOCK_SPIN_COUNT is set; see
+// __pthread_init_lock_spin_counts().
+__LIBC_HIDDEN__ extern int __pthread_mutex_spin_max;
+__LIBC_HIDDEN__ extern int __pthread_rwlock_spin_max;
+__LIBC_HIDDEN__ void __pthread_init_lock_spin_counts();
+
+// Tells the CPU we're in a spin-wait loop, so it can save power and give a sibling hardware
+// thread the pipeline until the lock we're waiting for has a chance to change.
+static inline __always_inline void __pthread_cpu_relax() {
+#if defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__riscv)
+  // Zihintpause's "pause", spelled out because we don't build with that extension enabled.
+  // It's a hint encoding of "fence", so cores without it treat it as a no-op.
+  __asm__ __volatile__(".insn i 0x0f, 0, x0, x0, 0x010" ::: "memory");
+#endif
+}
+
+// The number of iterations to spin on a lock whose recent contended acquisitions spun
+// |average| iterations: enough to cover twice the average, and at most |max|.
+static inline __always_inline int __pthread_spin_limit(int average, int max) {
+  int limit = average * 2 + 10;
+  return limit < max ? limit : max;
+}
+
+// Folds the iterations spun by one contended acquisition into the lock's running average.
+// Racing updates can lose each other, which is fine for a heuristic.
+static inline __always_inline void __pthread_spin_record(_Atomic(uint16_t)* average, int spins) {
+  int old_average = atomic_load_explicit(average, memory_order_relaxed);
+  atomic_store_explicit(average, old_average + (spins - old_average) / 8, memory_order_relaxed);
+}
+
 // Needed by fork.
 __LIBC_HIDDEN__ extern void __bionic_atfork_run_prepare();
 __LIBC_HIDDEN__ extern void __bionic_atfork_run_child();
@@ -37,6 +37,8 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <async_safe/log.h>
+
 #include "pthread_internal.h"
 
 #include "private/bionic_constants.h"
@@ -75,7 +77,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 {
     int type = (*attr & MUTEXATTR_TYPE_MASK);
 
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -85,7 +87,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK ) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -404,6 +406,18 @@ static void FreeId(int id) {
 #define  MUTEX_SHARED_SHIFT    13
 #define  MUTEX_SHARED_MASK     FIELD_MASK(MUTEX_SHARED_SHIFT,1)
 
+/* Mutex adaptive flag
+ *
+ * This flag is set in normal mutexes created as PTHREAD_MUTEX_ADAPTIVE_NP, which
+ * spin for a while before sleeping when they find the mutex locked. Normal mutexes
+ * never use the counter field, so this reuses its top bit.
+ */
+#define  MUTEX_ADAPTIVE_SHIFT  12
+#define  MUTEX_ADAPTIVE_MASK   FIELD_MASK(MUTEX_ADAPTIVE_SHIFT,1)
+
+/* The bits of a normal mutex state that don't change while it is locked and unlocked. */
+#define  MUTEX_NORMAL_FLAGS_MASK     (MUTEX_SHARED_MASK | MUTEX_ADAPTIVE_MASK)
+
 /* Mutex type:
  * We support normal, recursive and errorcheck mutexes.
  */
@@ -442,13 +456,18 @@ static void FreeId(int id) {
 //   15-14     type     mutex type, can be 0 (normal), 1 (recursive), 2 (errorcheck)
 //   13        shared   process-shared flag
 //   12-2      counter  <number of times a thread holding a recursive Non-PI mutex> - 1
+//   12        adaptive set in normal Non-PI mutexes created as PTHREAD_MUTEX_ADAPTIVE_NP
 //   1-0       state    lock state (0, 1 or 2)
 //
-//   bits 15-13 are constant during the lifetime of the mutex.
+//   bits 15-13 are constant during the lifetime of the mutex, as is bit 12 in normal mutexes.
 //
 //   owner_tid is used only in recursive and errorcheck Non-PI mutexes to hold the mutex owner
 //   thread id.
 //
+//   spins is the running average of how many iterations contended locks of an adaptive mutex
+//   have spun. There's no room for it in 32-bit programs, where adaptive mutexes always spin
+//   up to __pthread_mutex_spin_max iterations.
+//
 // PI mutexes and Non-PI mutexes are distinguished by checking type field in state.
 #if defined(__LP64__)
 struct pthread_mutex_internal_t {
@@ -458,7 +477,8 @@ struct pthread_mutex_internal_t {
         atomic_int owner_tid;
         PIMutex pi_mutex;
     };
-    char __reserved[28];
+    _Atomic(uint16_t) spins;
+    char __reserved[26];
 
     PIMutex& ToPIMutex() {
         return pi_mutex;
@@ -523,6 +543,9 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
     case PTHREAD_MUTEX_ERRORCHECK:
       state |= MUTEX_TYPE_BITS_ERRORCHECK;
       break;
+    case PTHREAD_MUTEX_ADAPTIVE_NP:
+      state |= MUTEX_TYPE_BITS_NORMAL | MUTEX_ADAPTIVE_MASK;
+      break;
     default:
         return EINVAL;
     }
@@ -540,7 +563,10 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
 #endif
         atomic_init(&mutex->state, PI_MUTEX_STATE);
         PIMutex& pi_mutex = mutex->ToPIMutex();
-        pi_mutex.type = *attr & MUTEXATTR_TYPE_MASK;
+        // PI mutexes are owned by the kernel as soon as they're contended, so there's
+        // nothing for an adaptive one to do differently from a normal one.
+        int type = *attr & MUTEXATTR_TYPE_MASK;
+        pi_mutex.type = (type == PTHREAD_MUTEX_ADAPTIVE_NP) ? PTHREAD_MUTEX_NORMAL : type;
         pi_mutex.shared = (*attr & MUTEXATTR_SHARED_MASK) != 0;
     } else {
         atomic_init(&mutex->state, state);
@@ -549,13 +575,41 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
     return 0;
 }
 
+// glibc's default for its glibc.pthread.mutex_spin_count tunable.
+int __pthread_mutex_spin_max = 100;
+int __pthread_rwlock_spin_max = 0;
+
+// BIONIC_LOCK_SPIN_COUNT=<n> sets how many iterations adaptive mutexes spin, and also lets
+// rwlocks spin that many iterations before sleeping. 0 turns spinning off altogether.
+void __pthread_init_lock_spin_counts() {
+  const char* env = getenv("BIONIC_LOCK_SPIN_COUNT");
+  if (env == nullptr) {
+    return;
+  }
+  char* end;
+  long count = strtol(env, &end, 10);
+  if (*env == '\0' || *end != '\0' || count < 0) {
+    async_safe_format_log(ANDROID_LOG_ERROR, "libc", "Invalid value for BIONIC_LOCK_SPIN_COUNT: %s",
+                          env);
+    return;
+  }
+  // The running averages are kept in 16 bits.
+  if (count > SHRT_MAX) {
+    count = SHRT_MAX;
+  }
+  __pthread_mutex_spin_max = count;
+  __pthread_rwlock_spin_max = count;
+}
+
 // namespace for Non-PI mutex routines.
 namespace NonPI {
 
+// The normal mutex routines take the mutex's constant state bits (its shared and adaptive
+// flags) as |flags|.
 static inline __always_inline int NormalMutexTryLock(pthread_mutex_internal_t* mutex,
-                                                     uint16_t shared) {
-    const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+                                                     uint16_t flags) {
+    const uint16_t unlocked           = flags | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_uncontended = flags | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
 
     uint16_t old_state = unlocked;
     if (__predict_true(atomic_compare_exchange_strong_explicit(&mutex->state, &old_state,
@@ -565,6 +619,44 @@ static inline __always_inline int NormalMutexTryLock(pthread_mutex_internal_t* m
     return EBUSY;
 }
 
+/*
+ * Spin on a contended adaptive Non-PI mutex, in the hope that its owner is running on
+ * another CPU and is about to unlock it, which saves the two context switches of sleeping
+ * and being woken. Like glibc, we spin for up to about twice as long as recent contended
+ * locks of this mutex have needed, and never more than __pthread_mutex_spin_max times.
+ *
+ * Returns 0 if we took the lock.
+ */
+static int AdaptiveMutexSpin(pthread_mutex_internal_t* mutex, uint16_t flags) {
+    const uint16_t unlocked = flags | MUTEX_STATE_BITS_UNLOCKED;
+
+#if defined(__LP64__)
+    int max_spins = __pthread_spin_limit(atomic_load_explicit(&mutex->spins,
+                                                              memory_order_relaxed),
+                                         __pthread_mutex_spin_max);
+#else
+    int max_spins = __pthread_mutex_spin_max;
+#endif
+    for (int spins = 1; spins <= max_spins; ++spins) {
+        __pthread_cpu_relax();
+        // Only try the compare-and-swap once the mutex looks unlocked, so spinners don't
+        // steal the cache line from the owner.
+        if (atomic_load_explicit(&mutex->state, memory_order_relaxed) == unlocked &&
+            NormalMutexTryLock(mutex, flags) == 0) {
+#if defined(__LP64__)
+            __pthread_spin_record(&mutex->spins, spins);
+#endif
+            return 0;
+        }
+    }
+#if defined(__LP64__)
+    if (max_spins > 0) {
+        __pthread_spin_record(&mutex->spins, max_spins);
+    }
+#endif
+    return EBUSY;
+}
+
 /*
  * Lock a normal Non-PI mutex.
  *
@@ -573,26 +665,30 @@ static inline __always_inline int NormalMutexTryLock(pthread_mutex_internal_t* m
  *   1 (locked, no contention)
  *   2 (locked, contention)
  *
- * Non-recursive mutexes don't use the thread-id or counter fields, and the
- * "type" value is zero, so the only bits that will be set are the ones in
- * the lock state field.
+ * Non-recursive mutexes don't use the thread-id field, the counter field holds
+ * nothing but the adaptive flag, and the "type" value is zero, so the only bits
+ * that will change are the ones in the lock state field.
  */
 static inline __always_inline int NormalMutexLock(pthread_mutex_internal_t* mutex,
-                                                  uint16_t shared,
+                                                  uint16_t flags,
                                                   bool use_realtime_clock,
                                                   const timespec* abs_timeout_or_null) {
-    if (__predict_true(NormalMutexTryLock(mutex, shared) == 0)) {
+    if (__predict_true(NormalMutexTryLock(mutex, flags) == 0)) {
         return 0;
     }
     int result = check_timespec(abs_timeout_or_null, true);
     if (result != 0) {
         return result;
     }
+    if ((flags & MUTEX_ADAPTIVE_MASK) != 0 && AdaptiveMutexSpin(mutex, flags) == 0) {
+        return 0;
+    }
 
     ScopedTrace trace("Contending for pthread mutex");
 
-    const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    const uint16_t shared           = flags & MUTEX_SHARED_MASK;
+    const uint16_t unlocked         = flags | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = flags | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     // We want to go to sleep until the mutex is available, which requires
     // promoting it to locked_contended. We need to swap in the new state
@@ -617,9 +713,10 @@ static inline __always_inline int NormalMutexLock(pthread_mutex_internal_t* mute
  * that we are in fact the owner of this lock.
  */
 static inline __always_inline void NormalMutexUnlock(pthread_mutex_internal_t* mutex,
-                                                     uint16_t shared) {
-    const uint16_t unlocked         = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+                                                     uint16_t flags) {
+    const uint16_t shared           = flags & MUTEX_SHARED_MASK;
+    const uint16_t unlocked         = flags | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = flags | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     // We use an atomic_exchange to release the lock. If locked_contended state
     // is returned, some threads is waiting for the lock and we need to wake up
@@ -716,7 +813,8 @@ static int MutexLockWithTimeout(pthread_mutex_internal_t* mutex, bool use_realti
 
     // Handle common case first.
     if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) ) {
-        return NormalMutexLock(mutex, shared, use_realtime_clock, abs_timeout_or_null);
+        uint16_t flags = (old_state & MUTEX_NORMAL_FLAGS_MASK);
+        return NormalMutexLock(mutex, flags, use_realtime_clock, abs_timeout_or_null);
     }
 
     // Do we already own this recursive or error-check mutex?
@@ -820,8 +918,8 @@ int pthread_mutex_lock(pthread_mutex_t* mutex_interface) {
     uint16_t mtype = (old_state & MUTEX_TYPE_MASK);
     // Avoid slowing down fast path of normal mutex lock operation.
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        uint16_t shared = (old_state & MUTEX_SHARED_MASK);
-        if (__predict_true(NonPI::NormalMutexTryLock(mutex, shared) == 0)) {
+        uint16_t flags = (old_state & MUTEX_NORMAL_FLAGS_MASK);
+        if (__predict_true(NonPI::NormalMutexTryLock(mutex, flags) == 0)) {
             return 0;
         }
     }
@@ -856,7 +954,8 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex_interface) {
 
     // Handle common case first.
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        NonPI::NormalMutexUnlock(mutex, shared);
+        uint16_t flags = (old_state & MUTEX_NORMAL_FLAGS_MASK);
+        NonPI::NormalMutexUnlock(mutex, flags);
         return 0;
     }
     if (old_state == PI_MUTEX_STATE) {
@@ -905,8 +1004,8 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex_interface) {
 
     // Handle common case first.
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        uint16_t shared = (old_state & MUTEX_SHARED_MASK);
-        return NonPI::NormalMutexTryLock(mutex, shared);
+        uint16_t flags = (old_state & MUTEX_NORMAL_FLAGS_MASK);
+        return NonPI::NormalMutexTryLock(mutex, flags);
     }
     if (old_state == PI_MUTEX_STATE) {
         return PIMutexTryLock(mutex->ToPIMutex());
@@ -968,8 +1067,8 @@ static int __pthread_mutex_timedlock(pthread_mutex_t* mutex_interface, bool use_
     uint16_t mtype = (old_state & MUTEX_TYPE_MASK);
     // Handle common case first.
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        uint16_t shared = (old_state & MUTEX_SHARED_MASK);
-        if (__predict_true(NonPI::NormalMutexTryLock(mutex, shared) == 0)) {
+        uint16_t flags = (old_state & MUTEX_NORMAL_FLAGS_MASK);
+        if (__predict_true(NonPI::NormalMutexTryLock(mutex, flags) == 0)) {
             return 0;
         }
     }
@@ -161,7 +161,9 @@ struct pthread_rwlock_internal_t {
 
   bool pshared;
   bool writer_nonrecursive_preferred;
-  uint16_t __pad;
+  // Running average of how many iterations contended lock calls have spun; see
+  // __pthread_rwlock_spin().
+  _Atomic(uint16_t) spins;
 
 // When a reader thread plans to suspend on the rwlock, it will add STATE_HAVE_PENDING_READERS_FLAG
 // in state, increase pending_reader_count, and wait on pending_reader_wakeup_serial. After woken
@@ -270,6 +272,33 @@ static inline __always_inline bool __can_acquire_read_lock(int old_state,
   return !cannot_apply;
 }
 
+static inline __always_inline bool __can_acquire_write_lock(int old_state) {
+  return !__state_owned_by_readers_or_writer(old_state);
+}
+
+// If BIONIC_LOCK_SPIN_COUNT is set, spin while the lock is unavailable, for up to about twice
+// as long as this rwlock's recent contended lock calls have had to. Returns true if the lock
+// became available, which lets a caller that would otherwise sleep avoid two context switches
+// when the lock is only held briefly.
+static bool __pthread_rwlock_spin(pthread_rwlock_internal_t* rwlock, bool writer) {
+  if (__pthread_rwlock_spin_max == 0) {
+    return false;
+  }
+  int max_spins = __pthread_spin_limit(atomic_load_explicit(&rwlock->spins, memory_order_relaxed),
+                                       __pthread_rwlock_spin_max);
+  for (int spins = 1; spins <= max_spins; ++spins) {
+    __pthread_cpu_relax();
+    int state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+    if (writer ? __can_acquire_write_lock(state)
+               : __can_acquire_read_lock(state, rwlock->writer_nonrecursive_preferred)) {
+      __pthread_spin_record(&rwlock->spins, spins);
+      return true;
+    }
+  }
+  __pthread_spin_record(&rwlock->spins, max_spins);
+  return false;
+}
+
 static inline __always_inline int __pthread_rwlock_tryrdlock(pthread_rwlock_internal_t* rwlock) {
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
@@ -293,6 +322,7 @@ static int __pthread_rwlock_timedrdlock(pthread_rwlock_internal_t* rwlock, bool
     return EDEADLK;
   }
 
+  bool spun = false;
   while (true) {
     int result = __pthread_rwlock_tryrdlock(rwlock);
     if (result == 0 || result == EAGAIN) {
@@ -307,6 +337,14 @@ static int __pthread_rwlock_timedrdlock(pthread_rwlock_internal_t* rwlock, bool
     if (__can_acquire_read_lock(old_state, rwlock->writer_nonrecursive_preferred)) {
       continue;
     }
+    // Only spin before sleeping the first time, so a lock that's held for a long time costs
+    // each waiter one bounded spin rather than one per wakeup.
+    if (!spun) {
+      spun = true;
+      if (__pthread_rwlock_spin(rwlock, false)) {
+        continue;
+      }
+    }
 
     rwlock->pending_lock.lock();
     rwlock->pending_reader_count++;
@@ -341,10 +379,6 @@ static int __pthread_rwlock_timedrdlock(pthread_rwlock_internal_t* rwlock, bool
   }
 }
 
-static inline __always_inline bool __can_acquire_write_lock(int old_state) {
-  return !__state_owned_by_readers_or_writer(old_state);
-}
-
 static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_internal_t* rwlock) {
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
@@ -364,6 +398,7 @@ static int __pthread_rwlock_timedwrlock(pthread_rwlock_internal_t* rwlock, bool
   if (atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) == __get_thread()->tid) {
     return EDEADLK;
   }
+  bool spun = false;
   while (true) {
     int result = __pthread_rwlock_trywrlock(rwlock);
     if (result == 0) {
@@ -378,6 +413,12 @@ static int __pthread_rwlock_timedwrlock(pthread_rwlock_internal_t* rwlock, bool
     if (__can_acquire_write_lock(old_state)) {
       continue;
     }
+    if (!spun) {
+      spun = true;
+      if (__pthread_rwlock_spin(rwlock, true)) {
+        continue;
+      }
+    }
 
     rwlock->pending_lock.lock();
     rwlock->pending_writer_count++;
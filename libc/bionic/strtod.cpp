@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strtod_tables.h"
+
+// The upstream gdtoa strtod and strtof are built under these names (see
+// libc_gdtoa in Android.bp), and remain responsible for every input the fast
+// path below doesn't handle: hex floats, infinities and NaNs, more than 19
+// significant digits, results that overflow or underflow (and so need errno
+// set), and the rare cases where the 128-bit approximation is inconclusive.
+extern "C" double __strtod_gdtoa(const char*, char**);
+extern "C" float __strtof_gdtoa(const char*, char**);
+
+namespace {
+
+struct DecimalNumber {
+  uint64_t mantissa;
+  int64_t exponent;
+  bool negative;
+  const char* end;
+};
+
+// Parses the common case of [space][sign]digits[.digits][(e|E)[sign]digits]
+// with at most 19 significant digits. Returns false if the input needs the
+// full gdtoa parser. Like gdtoa, the radix character is always '.'.
+static bool ParseDecimal(const char* s, DecimalNumber* result) {
+  while (*s == ' ' || (*s >= '\t' && *s <= '\r')) ++s;
+
+  result->negative = false;
+  if (*s == '-') {
+    result->negative = true;
+    ++s;
+  } else if (*s == '+') {
+    ++s;
+  }
+
+  // Leading zeros aren't significant.
+  const char* start = s;
+  while (*s == '0') ++s;
+  bool saw_digit = (s != start);
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int64_t exponent = 0;
+  while (static_cast<unsigned>(*s - '0') < 10) {
+    if (++digits > 19) return false;
+    mantissa = mantissa * 10 + (*s++ - '0');
+    saw_digit = true;
+  }
+  if (*s == '.') {
+    ++s;
+    if (mantissa == 0) {
+      // Zeros straight after the point only move the decimal exponent.
+      while (*s == '0') {
+        ++s;
+        --exponent;
+        saw_digit = true;
+      }
+    }
+    while (static_cast<unsigned>(*s - '0') < 10) {
+      if (++digits > 19) return false;
+      mantissa = mantissa * 10 + (*s++ - '0');
+      --exponent;
+      saw_digit = true;
+    }
+  }
+  // No digits at all means "inf", "nan", "0x" or garbage: let gdtoa decide.
+  if (!saw_digit) return false;
+
+  if (*s == 'e' || *s == 'E') {
+    const char* p = s + 1;
+    bool negative_exponent = false;
+    if (*p == '-') {
+      negative_exponent = true;
+      ++p;
+    } else if (*p == '+') {
+      ++p;
+    }
+    // An 'e' without any digits after it isn't part of the number.
+    if (static_cast<unsigned>(*p - '0') < 10) {
+      int64_t e = 0;
+      while (static_cast<unsigned>(*p - '0') < 10) {
+        // Anything this large overflows or underflows regardless of the
+        // mantissa, so it's not worth handling here.
+        if (e > 100000) return false;
+        e = e * 10 + (*p++ - '0');
+      }
+      exponent += negative_exponent ? -e : e;
+      s = p;
+    }
+  }
+
+  // gdtoa treats "0x" as the start of a hex float even when it's followed
+  // by something that isn't hex, so leave that to it too.
+  if (s - start == 1 && start[0] == '0' && (*s == 'x' || *s == 'X')) return false;
+
+  result->mantissa = mantissa;
+  result->exponent = exponent;
+  result->end = s;
+  return true;
+}
+
+static inline void Multiply64x64(uint64_t a, uint64_t b, uint64_t* high, uint64_t* low) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  *high = static_cast<uint64_t>(product >> 64);
+  *low = static_cast<uint64_t>(product);
+#else
+  uint64_t a_lo = static_cast<uint32_t>(a), a_hi = a >> 32;
+  uint64_t b_lo = static_cast<uint32_t>(b), b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + static_cast<uint32_t>(hi_lo) + lo_hi;
+  *high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  *low = (cross << 32) | static_cast<uint32_t>(lo_lo);
+#endif
+}
+
+// The Eisel-Lemire algorithm: computes the correctly rounded (to nearest,
+// ties to even) binary value of mantissa * 10^exponent using a 128-bit
+// approximation of 5^exponent. Returns false if the result is subnormal,
+// overflows, or the approximation isn't precise enough to decide the
+// rounding; the caller then falls back to gdtoa.
+template <int kMantissaBits, int kMinExponent, int kMaxExponent, int kMinRoundToEven,
+          int kMaxRoundToEven>
+static bool EiselLemire(uint64_t mantissa, int64_t exponent, uint64_t* bits) {
+  if (exponent < kMinExponent || exponent > kMaxExponent) return false;
+
+  int lz = __builtin_clzll(mantissa);
+  mantissa <<= lz;
+
+  const uint64_t* power = &kPowersOfFive128[2 * (exponent - kSmallestPowerOfFive)];
+  uint64_t high, low;
+  Multiply64x64(mantissa, power[0], &high, &low);
+
+  // If the bits below the ones we need are all set, the truncated product
+  // might be off by one in the last place we care about. Bring in the next
+  // 64 bits of the power of five to find out.
+  constexpr uint64_t kPrecisionMask = UINT64_MAX >> (kMantissaBits + 3);
+  if ((high & kPrecisionMask) == kPrecisionMask) {
+    uint64_t high2, low2;
+    Multiply64x64(mantissa, power[1], &high2, &low2);
+    low += high2;
+    if (high2 > low) ++high;
+    if (low == UINT64_MAX) return false;
+  }
+
+  int upper_bit = static_cast<int>(high >> 63);
+  uint64_t m = high >> (upper_bit + 64 - kMantissaBits - 3);
+  // floor(exponent * log2(10)) + 63, plus the exponent bias.
+  constexpr int kBias = (1 << (kMantissaBits == 52 ? 10 : 7)) - 1;
+  int64_t power2 = ((217706 * exponent) >> 16) + 63 + upper_bit - lz + kBias;
+  if (power2 <= 0) return false;
+
+  // A result that lands exactly halfway between two floats has to round to
+  // even; that can only happen for a narrow range of exponents.
+  if (low <= 1 && exponent >= kMinRoundToEven && exponent <= kMaxRoundToEven && (m & 3) == 1 &&
+      (m << (upper_bit + 64 - kMantissaBits - 3)) == high) {
+    m &= ~1ULL;
+  }
+
+  m += m & 1;
+  m >>= 1;
+  if (m >= (2ULL << kMantissaBits)) {
+    m = 1ULL << kMantissaBits;
+    ++power2;
+  }
+  m &= ~(1ULL << kMantissaBits);
+  if (power2 >= 2 * kBias + 1) return false;
+
+  *bits = m | (static_cast<uint64_t>(power2) << kMantissaBits);
+  return true;
+}
+
+}  // namespace
+
+double strtod(const char* s, char** end_ptr) {
+  DecimalNumber n;
+  if (ParseDecimal(s, &n)) {
+    uint64_t bits;
+    if (n.mantissa == 0) {
+      bits = 0;
+    } else if (!EiselLemire<52, -342, 308, -4, 23>(n.mantissa, n.exponent, &bits)) {
+      return __strtod_gdtoa(s, end_ptr);
+    }
+    if (n.negative) bits |= 1ULL << 63;
+    if (end_ptr != nullptr) *end_ptr = const_cast<char*>(n.end);
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+  return __strtod_gdtoa(s, end_ptr);
+}
+
+float strtof(const char* s, char** end_ptr) {
+  DecimalNumber n;
+  if (ParseDecimal(s, &n)) {
+    uint64_t bits;
+    if (n.mantissa == 0) {
+      bits = 0;
+    } else if (!EiselLemire<23, -65, 38, -17, 10>(n.mantissa, n.exponent, &bits)) {
+      return __strtof_gdtoa(s, end_ptr);
+    }
+    uint32_t bits32 = static_cast<uint32_t>(bits);
+    if (n.negative) bits32 |= 1U << 31;
+    if (end_ptr != nullptr) *end_ptr = const_cast<char*>(n.end);
+    float result;
+    memcpy(&result, &bits32, sizeof(result));
+    return result;
+  }
+  return __strtof_gdtoa(s, end_ptr);
+}
@@ -32,8 +32,110 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
+#include <type_traits>
+
+static inline bool IsDecimalDigit(int c) {
+  return static_cast<unsigned>(c - '0') < 10;
+}
+
+static inline bool IsHexDigit(int c) {
+  return IsDecimalDigit(c) || static_cast<unsigned>((c | 0x20) - 'a') < 6;
+}
+
+// Converts eight decimal digits, most significant first, in one go. The
+// caller has already checked that they're all digits. (All of bionic's
+// architectures are little-endian, so the first digit is in the low byte.)
+static inline uint64_t ParseEightDecimalDigits(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  v -= 0x3030303030303030ULL;
+  // Combine adjacent digits into two-digit values in each 16-bit lane...
+  v = (v * 10) + (v >> 8);
+  // ...and then those into a single eight-digit value.
+  return (((v & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))) +
+          (((v >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32)))) >> 32;
+}
+
+// Converts eight hex digits, most significant first, in one go. The caller
+// has already checked that they're all hex digits.
+static inline uint64_t ParseEightHexDigits(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  // '0'-'9' are 0x3X, 'A'-'F' are 0x4X, and 'a'-'f' are 0x6X, so bit 6 says
+  // whether we need to add 9 to the low nibble.
+  v = (v & 0x0f0f0f0f0f0f0f0fULL) + 9 * ((v >> 6) & 0x0101010101010101ULL);
+  // Pack the nibbles together, swapping each pair into big-endian order.
+  v = ((v << 4) | (v >> 8)) & 0x00ff00ff00ff00ffULL;
+  v = ((v << 8) | (v >> 16)) & 0x0000ffff0000ffffULL;
+  return ((v << 16) | (v >> 32)) & 0xffffffffULL;
+}
+
+// The common case of base 10 or 16 with narrow characters. Finds the end of
+// the run of digits first, so the conversion itself can work eight digits at
+// a time without reading past the end of the string. `p` points to the first
+// character after any sign and "0x" prefix. Returns exactly what the generic
+// loop in StrToI would, including errno and the end pointer.
+template <typename T, T Min, T Max>
+static T StrToIFast(const char* s, const char* p, char** end_ptr, int base, bool neg) {
+  const char* start = p;
+  // Leading zeros affect neither the value nor the overflow check.
+  while (*p == '0') ++p;
+  const char* digits = p;
+  if (base == 10) {
+    while (IsDecimalDigit(*p)) ++p;
+  } else {
+    while (IsHexDigit(*p)) ++p;
+  }
+  if (end_ptr != nullptr) *end_ptr = const_cast<char*>(p != start ? p : s);
+
+  // Every T fits in 64 bits, as does any 19-digit decimal or 16-digit hex
+  // number, so we accumulate the magnitude in a uint64_t and range check it
+  // at the end.
+  size_t n = p - digits;
+  uint64_t magnitude = 0;
+  bool overflow = false;
+  if (base == 10) {
+    if (n > 20) {
+      overflow = true;
+    } else {
+      for (; n >= 8; n -= 8, digits += 8) {
+        overflow |= __builtin_mul_overflow(magnitude, 100000000, &magnitude);
+        overflow |= __builtin_add_overflow(magnitude, ParseEightDecimalDigits(digits), &magnitude);
+      }
+      for (; n > 0; --n, ++digits) {
+        overflow |= __builtin_mul_overflow(magnitude, 10, &magnitude);
+        overflow |= __builtin_add_overflow(magnitude, *digits - '0', &magnitude);
+      }
+    }
+  } else {
+    if (n > 16) {
+      overflow = true;
+    } else {
+      for (; n >= 8; n -= 8, digits += 8) {
+        magnitude = (magnitude << 32) | ParseEightHexDigits(digits);
+      }
+      for (; n > 0; --n, ++digits) {
+        int c = *digits;
+        magnitude = (magnitude << 4) | (IsDecimalDigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+      }
+    }
+  }
+
+  using U = std::make_unsigned_t<T>;
+  constexpr bool is_signed = (Min != 0);
+  // The most negative value has a larger magnitude than the most positive value.
+  const uint64_t limit = (is_signed && neg) ? static_cast<U>(U(0) - static_cast<U>(Min)) : Max;
+  if (overflow || magnitude > limit) {
+    errno = ERANGE;
+    return (is_signed && neg) ? Min : Max;
+  }
+  U result = static_cast<U>(magnitude);
+  return static_cast<T>(neg ? U(0) - result : result);
+}
+
 template <typename T, T Min, T Max, typename CharT>
 __attribute__((always_inline)) T StrToI(const CharT* s, CharT** end_ptr, int base) {
   // Ensure that base is between 2 and 36 inclusive, or the special value of 0.
@@ -71,6 +173,10 @@ __attribute__((always_inline)) T StrToI(const CharT* s, CharT** end_ptr, int bas
   // If base is 0, allow "0" prefix for octal, otherwise base is 10.
   if (base == 0) base = (c == '0') ? 8 : 10;
 
+  if constexpr (sizeof(CharT) == 1) {
+    if (base == 10 || base == 16) return StrToIFast<T, Min, Max>(s, p - 1, end_ptr, base, neg);
+  }
+
   constexpr bool is_signed = (Min != 0);
   T acc = 0;
   // Non-zero if any digits consumed; negative to indicate overflow/underflow.
@@ -121,11 +121,31 @@ bool __system_property_wait(const prop_info* pi, uint32_t old_serial, uint32_t*
   return system_properties.Wait(pi, old_serial, new_serial_ptr, relative_timeout);
 }
 
+__BIONIC_WEAK_FOR_NATIVE_BRIDGE
+int __system_property_read_batch(const prop_info* const* pis, size_t count,
+                                 char (*values)[PROP_VALUE_MAX], uint32_t* serials) {
+  return system_properties.ReadBatch(pis, count, values, serials);
+}
+
+__BIONIC_WEAK_FOR_NATIVE_BRIDGE
+bool __system_property_wait_multiple(const prop_info* const* pis, const uint32_t* old_serials,
+                                     size_t count, uint32_t* new_serials,
+                                     const timespec* relative_timeout) {
+  return system_properties.WaitMultiple(pis, old_serials, count, new_serials, relative_timeout);
+}
+
 __BIONIC_WEAK_FOR_NATIVE_BRIDGE
 const prop_info* __system_property_find_nth(unsigned n) {
   return system_properties.FindNth(n);
 }
 
+__BIONIC_WEAK_FOR_NATIVE_BRIDGE
+int __system_properties_foreach_context(void (*callback)(const prop_context_stats* stats,
+                                                         void* cookie),
+                                        void* cookie) {
+  return system_properties.ForeachContext(callback, cookie);
+}
+
 __BIONIC_WEAK_FOR_NATIVE_BRIDGE
 int __system_property_foreach(void (*propfn)(const prop_info* pi, void* cookie), void* cookie) {
   return system_properties.Foreach(propfn, cookie);
@@ -19,6 +19,7 @@
 
 #include <limits.h>
 #include <link.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/auxv.h>
 #include <sys/cdefs.h>
@@ -73,6 +74,20 @@ time_t time(time_t* t) {
   if (__predict_true(vdso_time)) {
     return vdso_time(t);
   }
+#else
+  // Elsewhere, go straight to the vdso clock_gettime rather than through
+  // gettimeofday. This has to be CLOCK_REALTIME rather than the cheaper
+  // CLOCK_REALTIME_COARSE: the coarse clock lags by up to a tick, so time()
+  // could go backwards relative to a clock_gettime(CLOCK_REALTIME) just before it.
+  auto vdso_clock_gettime = reinterpret_cast<decltype(&clock_gettime)>(
+    __libc_globals->vdso[VDSO_CLOCK_GETTIME].fn);
+  if (__predict_true(vdso_clock_gettime)) {
+    timespec ts;
+    if (__predict_true(vdso_clock_gettime(CLOCK_REALTIME, &ts) == 0)) {
+      if (t) *t = ts.tv_sec;
+      return ts.tv_sec;
+    }
+  }
 #endif
 
   // We can't fallback to the time(2) system call because it doesn't exist for most architectures.
@@ -82,6 +97,25 @@ time_t time(time_t* t) {
   return tv.tv_sec;
 }
 
+extern "C" int __getcpu(unsigned*, unsigned*, void*);
+
+int sched_getcpu() {
+  unsigned cpu;
+#if defined(VDSO_GETCPU_SYMBOL)
+  auto vdso_getcpu =
+      reinterpret_cast<decltype(&__getcpu)>(__libc_globals->vdso[VDSO_GETCPU].fn);
+  if (__predict_true(vdso_getcpu)) {
+    if (vdso_return(vdso_getcpu(&cpu, nullptr, nullptr)) == -1) return -1;
+    return cpu;
+  }
+#endif
+  int rc = __getcpu(&cpu, nullptr, nullptr);
+  if (rc == -1) {
+    return -1; // errno is already set.
+  }
+  return cpu;
+}
+
 #if defined(__riscv)
 int __riscv_hwprobe(struct riscv_hwprobe* _Nonnull pairs, size_t pair_count, size_t cpu_count,
                     unsigned long* _Nullable cpus, unsigned flags) {
@@ -117,6 +151,9 @@ void __libc_init_vdso(libc_globals* globals) {
 #if defined(VDSO_RISCV_HWPROBE_SYMBOL)
   vdso[VDSO_RISCV_HWPROBE] = {VDSO_RISCV_HWPROBE_SYMBOL, nullptr};
 #endif
+#if defined(VDSO_GETCPU_SYMBOL)
+  vdso[VDSO_GETCPU] = {VDSO_GETCPU_SYMBOL, nullptr};
+#endif
 
   // Do we have a vdso?
   uintptr_t vdso_ehdr_addr = getauxval(AT_SYSINFO_EHDR);
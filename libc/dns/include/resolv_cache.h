@@ -43,7 +43,9 @@ typedef enum {
     RESOLV_CACHE_UNSUPPORTED,  /* the cache can't handle that kind of queries */
                                /* or the answer buffer is too small */
     RESOLV_CACHE_NOTFOUND,     /* the cache doesn't know about this query */
-    RESOLV_CACHE_FOUND         /* the cache found the answer */
+    RESOLV_CACHE_FOUND,        /* the cache found the answer */
+    RESOLV_CACHE_PENDING       /* another thread is already sending this query */
+                               /* (only from _resolv_cache_lookup_nowait) */
 } ResolvCacheStatus;
 
 __LIBC_HIDDEN__
@@ -55,6 +57,18 @@ _resolv_cache_lookup( unsigned              netid,
                       int                   answersize,
                       int                  *answerlen );
 
+/* like _resolv_cache_lookup, but rather than wait for another thread that's
+ * already sending the same query, return RESOLV_CACHE_PENDING
+ */
+__LIBC_HIDDEN__
+extern ResolvCacheStatus
+_resolv_cache_lookup_nowait( unsigned              netid,
+                             const void*           query,
+                             int                   querylen,
+                             void*                 answer,
+                             int                   answersize,
+                             int                  *answerlen );
+
 /* add a (query,answer) to the cache, only call if _resolv_cache_lookup
  * did return RESOLV_CACHE_NOTFOUND
  */
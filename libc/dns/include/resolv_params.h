@@ -46,6 +46,10 @@ struct __res_params {
     uint8_t min_samples; // min # samples needed for statistics to be considered meaningful
     uint8_t max_samples; // max # samples taken into account for statistics
     int base_timeout_msec;  // base query retry timeout (if 0, use RES_TIMEOUT)
+    // how long past their TTL cached answers may still be served while one thread
+    // refreshes them (0: expired answers are never served; negative values are
+    // rejected, and anything over three days is treated as three days)
+    int stale_ttl_sec;
 };
 
 typedef enum { res_goahead, res_nextns, res_modified, res_done, res_error }
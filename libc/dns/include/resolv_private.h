@@ -469,6 +469,8 @@ int		res_nmkquery(res_state, int, const char *, int, int,
 				  const u_char *, int, const u_char *,
 				  u_char *, int);
 int		res_nsend(res_state, const u_char *, int, u_char *, int);
+__LIBC_HIDDEN__ void	res_nsend_pair(res_state, const u_char *, int, u_char *, int, int *,
+				       const u_char *, int, u_char *, int, int *);
 int		res_nsendsigned(res_state, const u_char *, int,
 				     ns_tsig_key *, u_char *, int);
 int		res_findzonecut(res_state, const char *, ns_class, int,
@@ -107,6 +107,7 @@
 #include <syslog.h>
 #include <stdarg.h>
 #include "nsswitch.h"
+#include "hosts_cache.h"
 #include "private/bionic_defs.h"
 
 typedef union sockaddr_union {
@@ -242,6 +243,8 @@ static void _sethtent(FILE **);
 static void _endhtent(FILE **);
 static struct addrinfo *_gethtent(FILE **, const char *,
     const struct addrinfo *);
+static struct addrinfo *_htent_getaddrinfo(const char *, const char *,
+    const struct addrinfo *);
 static int _files_getaddrinfo(void *, void *, va_list);
 static int _find_src_addr(const struct sockaddr *, struct sockaddr *, unsigned , uid_t);
 
@@ -2046,13 +2049,42 @@ _endhtent(FILE **hostf)
 	}
 }
 
+/*
+ * Returns the addrinfos for the address of a hosts file line, or NULL if
+ * it isn't usable. cname is the first name on the line.
+ */
+static struct addrinfo *
+_htent_getaddrinfo(const char *addr, const char *cname,
+    const struct addrinfo *pai)
+{
+	struct addrinfo hints, *res0, *res;
+	int error;
+
+	hints = *pai;
+	hints.ai_flags = AI_NUMERICHOST;
+	error = getaddrinfo(addr, NULL, &hints, &res0);
+	if (error)
+		return NULL;
+	for (res = res0; res; res = res->ai_next) {
+		/* cover it up */
+		res->ai_flags = pai->ai_flags;
+
+		if (pai->ai_flags & AI_CANONNAME) {
+			if (get_canonname(pai, res, cname) != 0) {
+				freeaddrinfo(res0);
+				return NULL;
+			}
+		}
+	}
+	return res0;
+}
+
 static struct addrinfo *
 _gethtent(FILE **hostf, const char *name, const struct addrinfo *pai)
 {
 	char *p;
 	char *cp, *tname, *cname;
-	struct addrinfo hints, *res0, *res;
-	int error;
+	struct addrinfo *res0;
 	const char *addr;
 	char hostbuf[8*1024];
 
@@ -2093,23 +2125,29 @@ _gethtent(FILE **hostf, const char *name, const struct addrinfo *pai)
 	goto again;
 
 found:
-	hints = *pai;
-	hints.ai_flags = AI_NUMERICHOST;
-	error = getaddrinfo(addr, NULL, &hints, &res0);
-	if (error)
+	res0 = _htent_getaddrinfo(addr, cname, pai);
+	if (res0 == NULL)
 		goto again;
-	for (res = res0; res; res = res->ai_next) {
-		/* cover it up */
-		res->ai_flags = pai->ai_flags;
+	return res0;
+}
 
-		if (pai->ai_flags & AI_CANONNAME) {
-			if (get_canonname(pai, res, cname) != 0) {
-				freeaddrinfo(res0);
-				goto again;
-			}
-		}
+struct files_getaddrinfo_state {
+	const struct addrinfo *pai;
+	struct addrinfo *cur;
+};
+
+static void
+_files_getaddrinfo_cb(const char *addr, const char *cname, void *arg)
+{
+	struct files_getaddrinfo_state *state = arg;
+	struct addrinfo *p;
+
+	p = _htent_getaddrinfo(addr, cname, state->pai);
+	if (p != NULL) {
+		state->cur->ai_next = p;
+		while (state->cur && state->cur->ai_next)
+			state->cur = state->cur->ai_next;
 	}
-	return res0;
 }
 
 /*ARGSUSED*/
@@ -2129,13 +2167,17 @@ _files_getaddrinfo(void *rv, void *cb_data, va_list ap)
 	memset(&sentinel, 0, sizeof(sentinel));
 	cur = &sentinel;
 
-	_sethtent(&hostf);
-	while ((p = _gethtent(&hostf, name, pai)) != NULL) {
-		cur->ai_next = p;
-		while (cur && cur->ai_next)
-			cur = cur->ai_next;
+	/* Use the index of the hosts file if we can, and only read it if not. */
+	struct files_getaddrinfo_state state = { pai, cur };
+	if (_hosts_cache_foreach(name, _files_getaddrinfo_cb, &state) == -1) {
+		_sethtent(&hostf);
+		while ((p = _gethtent(&hostf, name, pai)) != NULL) {
+			cur->ai_next = p;
+			while (cur && cur->ai_next)
+				cur = cur->ai_next;
+		}
+		_endhtent(&hostf);
 	}
-	_endhtent(&hostf);
 
 	*((struct addrinfo **)rv) = sentinel.ai_next;
 	if (sentinel.ai_next == NULL)
@@ -2160,11 +2202,14 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
     res_state res)
 {
 	u_char buf[MAXPACKET];
+	u_char buf2[PACKETSZ];
 	HEADER *hp;
-	int n;
+	int n, i;
 	struct res_target *t;
 	int rcode;
 	int ancount;
+	int use_pair, pair_n[2];
+	u_int pair_oflags;
 
 	assert(name != NULL);
 	/* XXX: target may be NULL??? */
@@ -2172,16 +2217,55 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 	rcode = NOERROR;
 	ancount = 0;
 
-	for (t = target; t; t = t->next) {
+	/*
+	 * An AF_UNSPEC lookup asks two questions about the same name, so ask
+	 * them both at once rather than waiting for one answer before sending
+	 * the next question. The loop below then just checks the answers.
+	 */
+	use_pair = 0;
+	pair_oflags = res->_flags;
+	if (target->next != NULL && target->next->next == NULL) {
+		struct res_target *t2 = target->next;
+		int n1, n2;
+
+		n1 = res_nmkquery(res, QUERY, name, target->qclass, target->qtype,
+		    NULL, 0, NULL, buf, sizeof(buf));
+		n2 = res_nmkquery(res, QUERY, name, t2->qclass, t2->qtype,
+		    NULL, 0, NULL, buf2, sizeof(buf2));
+#ifdef RES_USE_EDNS0
+		if ((res->_flags & RES_F_EDNS0ERR) == 0 &&
+		    (res->options & (RES_USE_EDNS0|RES_USE_DNSSEC)) != 0) {
+			if (n1 > 0)
+				n1 = res_nopt(res, n1, buf, sizeof(buf), target->anslen);
+			if (n2 > 0)
+				n2 = res_nopt(res, n2, buf2, sizeof(buf2), t2->anslen);
+		}
+#endif
+		if (n1 > 0 && n2 > 0) {
+			((HEADER *)(void *)target->answer)->rcode = NOERROR;
+			((HEADER *)(void *)t2->answer)->rcode = NOERROR;
+			res_nsend_pair(res, buf, n1, target->answer, target->anslen, &pair_n[0],
+			    buf2, n2, t2->answer, t2->anslen, &pair_n[1]);
+			use_pair = 1;
+		}
+	}
+
+	for (t = target, i = 0; t; t = t->next, i++) {
 		int class, type;
 		u_char *answer;
 		int anslen;
 		u_int oflags;
+		int from_pair;
 
 		hp = (HEADER *)(void *)t->answer;
-		oflags = res->_flags;
+		oflags = use_pair ? pair_oflags : res->_flags;
+		from_pair = use_pair;
 
 again:
+		if (from_pair) {
+			n = pair_n[i];
+			goto sent;
+		}
 		hp->rcode = NOERROR;	/* default */
 
 		/* make it easier... */
@@ -2210,6 +2294,7 @@ again:
 			return n;
 		}
 		n = res_nsend(res, buf, n, answer, anslen);
+sent:
 #if 0
 		if (n < 0) {
 #ifdef DEBUG
@@ -2232,6 +2317,7 @@ again:
 				if (res->options & RES_DEBUG)
 					printf(";; res_nquery: retry without EDNS0\n");
 #endif
+				from_pair = 0;
 				goto again;
 			}
 #endif
@@ -29,6 +29,7 @@
 #include <netdb.h>
 
 #include <endian.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -118,34 +119,44 @@ struct servent* getservent(void) {
   return rs ? getservent_r(rs) : NULL;
 }
 
-struct servent* getservbyname(const char* name, const char* proto) {
-  struct res_static* rs = __res_get_static();
-  if (rs == NULL) return NULL;
-
-  const char* old_servent_ptr = rs->servent_ptr;
-  rs->servent_ptr = NULL;
-  struct servent* s;
-  while ((s = getservent_r(rs)) != NULL) {
-    if (strcmp(s->s_name, name) == 0 && (proto == NULL || strcmp(s->s_proto, proto) == 0)) {
-      break;
+// Finds the first entry with the given name (if name isn't NULL) or port (in
+// network byte order), and proto (if that isn't NULL). This walks the packed
+// table directly, and only builds a servent for the match.
+static struct servent* find_servent(struct res_static* rs, const char* name, int port,
+                                    const char* proto) {
+  size_t name_len = (name != NULL) ? strlen(name) : 0;
+  const char* p = _services;
+  while (p[0] != 0) {
+    const char* entry = p;
+    size_t len = (unsigned char) p[0];
+    p += 1 + len;
+    int entry_port = htons((((unsigned char*)p)[0] << 8) | ((unsigned char*)p)[1]);
+    const char* entry_proto = p[2] == 't' ? "tcp" : "udp";
+    int count = p[3];
+    p += 4;
+    for (int nn = 0; nn < count; nn++) {
+      p += 1 + (unsigned char) p[0];
+    }
+
+    bool match = (name != NULL) ? (len == name_len && memcmp(entry + 1, name, len) == 0)
+                                : (entry_port == port);
+    if (match && (proto == NULL || strcmp(entry_proto, proto) == 0)) {
+      const char* old_servent_ptr = rs->servent_ptr;
+      rs->servent_ptr = entry;
+      struct servent* s = getservent_r(rs);
+      rs->servent_ptr = old_servent_ptr;
+      return s;
     }
   }
-  rs->servent_ptr = old_servent_ptr;
-  return s;
+  return NULL;
+}
+
+struct servent* getservbyname(const char* name, const char* proto) {
+  struct res_static* rs = __res_get_static();
+  return rs ? find_servent(rs, name, 0, proto) : NULL;
 }
 
 struct servent* getservbyport(int port, const char* proto) {
   struct res_static* rs = __res_get_static();
-  if (rs == NULL) return NULL;
-
-  const char* old_servent_ptr = rs->servent_ptr;
-  rs->servent_ptr = NULL;
-  struct servent* s;
-  while ((s = getservent_r(rs)) != NULL) {
-    if (s->s_port == port && (proto == NULL || strcmp(s->s_proto, proto) == 0)) {
-      break;
-    }
-  }
-  rs->servent_ptr = old_servent_ptr;
-  return s;
+  return rs ? find_servent(rs, NULL, port, proto) : NULL;
 }
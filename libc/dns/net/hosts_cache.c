@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include "hosts_cache.h"
+
+#include <arpa/nameser.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * The hosts file is mapped read-only, and indexed by a hash table keyed on
+ * the (case-insensitive) host name. Each name on each line gets an entry,
+ * so finding every line for a name only visits entries with the same hash.
+ * All offsets are into the mapping, which is why files of 4GiB or more
+ * aren't indexed.
+ */
+
+#define HC_NONE UINT32_MAX
+
+struct hc_entry {
+  uint32_t name, name_len;
+  uint32_t addr, addr_len;
+  uint32_t cname, cname_len;
+  uint32_t line;   /* so a name listed twice on one line is only reported once */
+  uint32_t next;   /* the next entry in the same bucket, in file order */
+};
+
+static struct {
+  struct stat st;
+  const char* data;
+  size_t size;
+  struct hc_entry* entries;
+  uint32_t entry_count;
+  uint32_t* buckets;
+  uint32_t bucket_mask;
+} hc;
+
+static pthread_mutex_t hc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hc_hash(const char* s, size_t n) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < n; ++i) {
+    h ^= (uint8_t)tolower((unsigned char)s[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void hc_free_locked(void) {
+  if (hc.data != NULL) munmap((void*)hc.data, hc.size);
+  free(hc.entries);
+  free(hc.buckets);
+  memset(&hc, 0, sizeof(hc));
+}
+
+static int hc_is_space(char c) {
+  return c == ' ' || c == '\t';
+}
+
+/* Parses the mapped file into hc.entries, in file order. */
+static int hc_parse_locked(void) {
+  const char* p = hc.data;
+  const char* end = hc.data + hc.size;
+  uint32_t capacity = 0;
+
+  while (p < end) {
+    const char* line = p;
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (eol == NULL) eol = end;
+    p = eol + 1;
+
+    /* Everything after a '#' is a comment. */
+    const char* hash = (const char*)memchr(line, '#', eol - line);
+    if (hash != NULL) eol = hash;
+
+    const char* cp = line;
+    while (cp < eol && !hc_is_space(*cp)) ++cp;
+    if (cp == line || cp == eol) continue;
+    uint32_t addr = line - hc.data, addr_len = cp - line;
+
+    uint32_t cname = 0, cname_len = 0;
+    while (cp < eol) {
+      if (hc_is_space(*cp)) {
+        ++cp;
+        continue;
+      }
+      const char* name = cp;
+      while (cp < eol && !hc_is_space(*cp)) ++cp;
+      if (cname_len == 0) {
+        cname = name - hc.data;
+        cname_len = cp - name;
+      }
+
+      if (hc.entry_count == capacity) {
+        uint32_t new_capacity = capacity ? capacity * 2 : 64;
+        struct hc_entry* new_entries =
+            (struct hc_entry*)reallocarray(hc.entries, new_capacity, sizeof(*new_entries));
+        if (new_entries == NULL) return -1;
+        hc.entries = new_entries;
+        capacity = new_capacity;
+      }
+      struct hc_entry* e = &hc.entries[hc.entry_count++];
+      e->name = name - hc.data;
+      e->name_len = cp - name;
+      e->addr = addr;
+      e->addr_len = addr_len;
+      e->cname = cname;
+      e->cname_len = cname_len;
+      e->line = line - hc.data;
+    }
+  }
+  return 0;
+}
+
+static int hc_build_locked(const struct stat* st) {
+  hc_free_locked();
+  if (st->st_size == 0 || (uint64_t)st->st_size >= HC_NONE) return -1;
+
+  int fd = open(_PATH_HOSTS, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return -1;
+  void* data = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return -1;
+  hc.data = (const char*)data;
+  hc.size = st->st_size;
+
+  if (hc_parse_locked() == -1) {
+    hc_free_locked();
+    return -1;
+  }
+
+  uint32_t bucket_count = 16;
+  while (bucket_count < hc.entry_count) bucket_count *= 2;
+  hc.buckets = (uint32_t*)malloc(bucket_count * sizeof(*hc.buckets));
+  if (hc.buckets == NULL) {
+    hc_free_locked();
+    return -1;
+  }
+  memset(hc.buckets, 0xff, bucket_count * sizeof(*hc.buckets));
+  hc.bucket_mask = bucket_count - 1;
+
+  /* Insert backwards so that each chain ends up in file order. */
+  for (uint32_t i = hc.entry_count; i-- > 0;) {
+    struct hc_entry* e = &hc.entries[i];
+    uint32_t* bucket = &hc.buckets[hc_hash(hc.data + e->name, e->name_len) & hc.bucket_mask];
+    e->next = *bucket;
+    *bucket = i;
+  }
+
+  hc.st = *st;
+  return 0;
+}
+
+static int hc_is_current_locked(const struct stat* st) {
+  return hc.data != NULL && hc.st.st_dev == st->st_dev && hc.st.st_ino == st->st_ino &&
+         hc.st.st_size == st->st_size && hc.st.st_mtim.tv_sec == st->st_mtim.tv_sec &&
+         hc.st.st_mtim.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+int _hosts_cache_foreach(const char* name,
+                         void (*fn)(const char* addr, const char* cname, void* arg),
+                         void* arg) {
+  struct stat st;
+  if (stat(_PATH_HOSTS, &st) == -1) return -1;
+
+  pthread_mutex_lock(&hc_lock);
+  if (!hc_is_current_locked(&st) && hc_build_locked(&st) == -1) {
+    pthread_mutex_unlock(&hc_lock);
+    return -1;
+  }
+
+  size_t name_len = strlen(name);
+  uint32_t last_line = HC_NONE;
+  int found = 0;
+  for (uint32_t i = hc.buckets[hc_hash(name, name_len) & hc.bucket_mask]; i != HC_NONE;
+       i = hc.entries[i].next) {
+    const struct hc_entry* e = &hc.entries[i];
+    if (e->name_len != name_len || strncasecmp(hc.data + e->name, name, name_len) != 0) continue;
+    if (e->line == last_line) continue;
+    last_line = e->line;
+
+    /* Anything too long for these can't be a valid address or host name anyway. */
+    char addr[INET6_ADDRSTRLEN + IF_NAMESIZE + 1];
+    char cname[NS_MAXDNAME];
+    if (e->addr_len >= sizeof(addr) || e->cname_len >= sizeof(cname)) continue;
+    memcpy(addr, hc.data + e->addr, e->addr_len);
+    addr[e->addr_len] = '\0';
+    memcpy(cname, hc.data + e->cname, e->cname_len);
+    cname[e->cname_len] = '\0';
+
+    fn(addr, cname, arg);
+    ++found;
+  }
+  pthread_mutex_unlock(&hc_lock);
+  return found;
+}
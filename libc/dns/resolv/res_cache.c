@@ -1276,13 +1276,29 @@ typedef struct pending_req_info {
     struct pending_req_info*    next;
 } PendingReqInfo;
 
-typedef struct resolv_cache {
+/* The entries of each cache are split by hash into CONFIG_CACHE_SHARDS
+ * shards, each with its own lock, hash table and MRU list, so that lookups
+ * for different names don't all serialize on one lock.
+ */
+#define CONFIG_CACHE_SHARDS 8
+
+typedef struct cache_shard {
+    pthread_mutex_t  lock;
     int              max_entries;
     int              num_entries;
     Entry            mru_list;
     int              last_id;
-    Entry*           entries;
+    Entry**          entries;
+} CacheShard;
+
+/* The most that __res_params.stale_ttl_sec may be; larger values are clamped.
+ * RFC 8767 suggests not serving stale answers for more than three days. */
+#define MAX_STALE_TTL_SEC (3 * 24 * 60 * 60)
+
+typedef struct resolv_cache {
+    CacheShard       shards[CONFIG_CACHE_SHARDS];
     PendingReqInfo   pending_requests;
+    int              stale_ttl;  /* see __res_params.stale_ttl_sec */
 } Cache;
 
 struct resolv_cache_info {
@@ -1305,8 +1321,14 @@ static pthread_once_t        _res_cache_once = PTHREAD_ONCE_INIT;
 static void _res_cache_init(void);
 
 // lock protecting everything in the _resolve_cache_info structs (next ptr, etc)
+// except the cache entries, which are protected by the lock of their shard.
 static pthread_mutex_t _res_cache_list_lock;
 
+// Adding a cache to the list or removing one takes this for writing as well as
+// _res_cache_list_lock, so a cache hit only needs to take it for reading to
+// know that the cache it found stays around.
+static pthread_rwlock_t _res_cache_rwlock;
+
 /* gets cache associated with a network, or NULL if none exists */
 static struct resolv_cache* _find_named_cache_locked(unsigned netid);
 
@@ -1330,36 +1352,48 @@ _cache_flush_pending_requests_locked( struct resolv_cache* cache )
     }
 }
 
+/* Return the pending request matching the key, if there is one.
+ * Otherwise record that the calling thread is about to send the
+ * query, so that others asking the same question can wait for it,
+ * and return NULL. */
+static struct pending_req_info*
+_cache_find_pending_request_locked( struct resolv_cache* cache, Entry* key )
+{
+    struct pending_req_info *ri, *prev;
+
+    ri = cache->pending_requests.next;
+    prev = &cache->pending_requests;
+    while (ri) {
+        if (ri->hash == key->hash) {
+            return ri;
+        }
+        prev = ri;
+        ri = ri->next;
+    }
+
+    ri = calloc(1, sizeof(struct pending_req_info));
+    if (ri) {
+        ri->hash = key->hash;
+        pthread_cond_init(&ri->cond, NULL);
+        prev->next = ri;
+    }
+    return NULL;
+}
+
 /* Return 0 if no pending request is found matching the key.
  * If a matching request is found the calling thread will wait until
  * the matching request completes, then update *cache and return 1. */
 static int
 _cache_check_pending_request_locked( struct resolv_cache** cache, Entry* key, unsigned netid )
 {
-    struct pending_req_info *ri, *prev;
+    struct pending_req_info *ri;
     int exist = 0;
 
     if (*cache && key) {
-        ri = (*cache)->pending_requests.next;
-        prev = &(*cache)->pending_requests;
-        while (ri) {
-            if (ri->hash == key->hash) {
-                exist = 1;
-                break;
-            }
-            prev = ri;
-            ri = ri->next;
-        }
-
-        if (!exist) {
-            ri = calloc(1, sizeof(struct pending_req_info));
-            if (ri) {
-                ri->hash = key->hash;
-                pthread_cond_init(&ri->cond, NULL);
-                prev->next = ri;
-            }
-        } else {
+        ri = _cache_find_pending_request_locked(*cache, key);
+        if (ri != NULL) {
             struct timespec ts = {0,0};
+            exist = 1;
             XLOG("Waiting for previous request");
             ts.tv_sec = _time_now() + PENDING_REQUEST_TIMEOUT;
             pthread_cond_timedwait(&ri->cond, &_res_cache_list_lock, &ts);
@@ -1427,26 +1461,33 @@ static struct resolv_cache_info* _find_cache_info_locked(unsigned netid);
 static void
 _cache_flush_locked( Cache*  cache )
 {
-    int     nn;
+    int     nn, ss;
 
-    for (nn = 0; nn < cache->max_entries; nn++)
+    for (ss = 0; ss < CONFIG_CACHE_SHARDS; ss++)
     {
-        Entry**  pnode = (Entry**) &cache->entries[nn];
+        CacheShard*  shard = &cache->shards[ss];
+
+        pthread_mutex_lock(&shard->lock);
+        for (nn = 0; nn < shard->max_entries; nn++)
+        {
+            Entry**  pnode = &shard->entries[nn];
 
-        while (*pnode != NULL) {
-            Entry*  node = *pnode;
-            *pnode = node->hlink;
-            entry_free(node);
+            while (*pnode != NULL) {
+                Entry*  node = *pnode;
+                *pnode = node->hlink;
+                entry_free(node);
+            }
         }
+
+        shard->mru_list.mru_next = shard->mru_list.mru_prev = &shard->mru_list;
+        shard->num_entries       = 0;
+        shard->last_id           = 0;
+        pthread_mutex_unlock(&shard->lock);
     }
 
     // flush pending request
     _cache_flush_pending_requests_locked(cache);
 
-    cache->mru_list.mru_next = cache->mru_list.mru_prev = &cache->mru_list;
-    cache->num_entries       = 0;
-    cache->last_id           = 0;
-
     XLOG("*************************\n"
          "*** DNS CACHE FLUSHED ***\n"
          "*************************");
@@ -1467,22 +1508,43 @@ _res_cache_get_max_entries( void )
     return cache_size;
 }
 
+static void
+_resolv_cache_free( struct resolv_cache*  cache )
+{
+    int  ss;
+
+    _cache_flush_locked(cache);
+    for (ss = 0; ss < CONFIG_CACHE_SHARDS; ss++) {
+        pthread_mutex_destroy(&cache->shards[ss].lock);
+        free(cache->shards[ss].entries);
+    }
+    free(cache);
+}
+
 static struct resolv_cache*
 _resolv_cache_create( void )
 {
     struct resolv_cache*  cache;
+    int                   max_entries, ss;
 
     cache = calloc(sizeof(*cache), 1);
     if (cache) {
-        cache->max_entries = _res_cache_get_max_entries();
-        cache->entries = calloc(sizeof(*cache->entries), cache->max_entries);
-        if (cache->entries) {
-            cache->mru_list.mru_prev = cache->mru_list.mru_next = &cache->mru_list;
-            XLOG("%s: cache created\n", __FUNCTION__);
-        } else {
-            free(cache);
-            cache = NULL;
+        max_entries = _res_cache_get_max_entries() / CONFIG_CACHE_SHARDS;
+        for (ss = 0; ss < CONFIG_CACHE_SHARDS; ss++) {
+            CacheShard*  shard = &cache->shards[ss];
+
+            pthread_mutex_init(&shard->lock, NULL);
+            shard->mru_list.mru_prev = shard->mru_list.mru_next = &shard->mru_list;
+            if (max_entries > 0) {
+                shard->entries = calloc(sizeof(*shard->entries), max_entries);
+                if (shard->entries == NULL) {
+                    _resolv_cache_free(cache);
+                    return NULL;
+                }
+                shard->max_entries = max_entries;
+            }
         }
+        XLOG("%s: cache created\n", __FUNCTION__);
     }
     return cache;
 }
@@ -1501,13 +1563,13 @@ _dump_query( const uint8_t*  query, int  querylen )
 }
 
 static void
-_cache_dump_mru( Cache*  cache )
+_cache_dump_mru( CacheShard*  shard )
 {
     char    temp[512], *p=temp, *end=p+sizeof(temp);
     Entry*  e;
 
-    p = _bprint(temp, end, "MRU LIST (%2d): ", cache->num_entries);
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list; e = e->mru_next)
+    p = _bprint(temp, end, "MRU LIST (%2d): ", shard->num_entries);
+    for (e = shard->mru_list.mru_next; e != &shard->mru_list; e = e->mru_next)
         p = _bprint(p, end, " %d", e->id);
 
     XLOG("%s", temp);
@@ -1568,14 +1630,15 @@ _dump_answer(const void* answer, int answerlen)
  * for the key position in the htable.
  *
  * The result of a lookup_p is only valid until you alter the hash
- * table.
+ * table. The caller must hold the shard's lock, and the shard must
+ * have room for at least one entry.
  */
 static Entry**
-_cache_lookup_p( Cache*   cache,
-                 Entry*   key )
+_cache_lookup_p( CacheShard*  shard,
+                 Entry*       key )
 {
-    int      index = key->hash % cache->max_entries;
-    Entry**  pnode = (Entry**) &cache->entries[ index ];
+    int      index = (key->hash / CONFIG_CACHE_SHARDS) % shard->max_entries;
+    Entry**  pnode = &shard->entries[ index ];
 
     while (*pnode != NULL) {
         Entry*  node = *pnode;
@@ -1597,17 +1660,17 @@ _cache_lookup_p( Cache*   cache,
  * newly created entry
  */
 static void
-_cache_add_p( Cache*   cache,
-              Entry**  lookup,
-              Entry*   e )
+_cache_add_p( CacheShard*  shard,
+              Entry**      lookup,
+              Entry*       e )
 {
     *lookup = e;
-    e->id = ++cache->last_id;
-    entry_mru_add(e, &cache->mru_list);
-    cache->num_entries += 1;
+    e->id = ++shard->last_id;
+    entry_mru_add(e, &shard->mru_list);
+    shard->num_entries += 1;
 
     XLOG("%s: entry %d added (count=%d)", __FUNCTION__,
-         e->id, cache->num_entries);
+         e->id, shard->num_entries);
 }
 
 /* Remove an existing entry from the hash table,
@@ -1615,27 +1678,27 @@ _cache_add_p( Cache*   cache,
  * and succesful _lookup_p() call.
  */
 static void
-_cache_remove_p( Cache*   cache,
-                 Entry**  lookup )
+_cache_remove_p( CacheShard*  shard,
+                 Entry**      lookup )
 {
     Entry*  e  = *lookup;
 
     XLOG("%s: entry %d removed (count=%d)", __FUNCTION__,
-         e->id, cache->num_entries-1);
+         e->id, shard->num_entries-1);
 
     entry_mru_remove(e);
     *lookup = e->hlink;
     entry_free(e);
-    cache->num_entries -= 1;
+    shard->num_entries -= 1;
 }
 
 /* Remove the oldest entry from the hash table.
  */
 static void
-_cache_remove_oldest( Cache*  cache )
+_cache_remove_oldest( CacheShard*  shard )
 {
-    Entry*   oldest = cache->mru_list.mru_prev;
-    Entry**  lookup = _cache_lookup_p(cache, oldest);
+    Entry*   oldest = shard->mru_list.mru_prev;
+    Entry**  lookup = _cache_lookup_p(shard, oldest);
 
     if (*lookup == NULL) { /* should not happen */
         XLOG("%s: OLDEST NOT IN HTABLE ?", __FUNCTION__);
@@ -1645,95 +1708,79 @@ _cache_remove_oldest( Cache*  cache )
         XLOG("Cache full - removing oldest");
         XLOG_QUERY(oldest->query, oldest->querylen);
     }
-    _cache_remove_p(cache, lookup);
+    _cache_remove_p(shard, lookup);
 }
 
-/* Remove all expired entries from the hash table.
+/* Remove all expired entries from the hash table, except those
+ * that can still be served stale.
  */
-static void _cache_remove_expired(Cache* cache) {
+static void _cache_remove_expired(CacheShard* shard, int stale_ttl) {
     Entry* e;
     time_t now = _time_now();
 
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list;) {
+    for (e = shard->mru_list.mru_next; e != &shard->mru_list;) {
         // Entry is old, remove
-        if (now >= e->expires) {
-            Entry** lookup = _cache_lookup_p(cache, e);
+        if (now >= e->expires + stale_ttl) {
+            Entry** lookup = _cache_lookup_p(shard, e);
             if (*lookup == NULL) { /* should not happen */
                 XLOG("%s: ENTRY NOT IN HTABLE ?", __FUNCTION__);
                 return;
             }
             e = e->mru_next;
-            _cache_remove_p(cache, lookup);
+            _cache_remove_p(shard, lookup);
         } else {
             e = e->mru_next;
         }
     }
 }
 
-ResolvCacheStatus
-_resolv_cache_lookup( unsigned              netid,
-                      const void*           query,
-                      int                   querylen,
-                      void*                 answer,
-                      int                   answersize,
-                      int                  *answerlen )
-{
-    Entry      key[1];
-    Entry**    lookup;
-    Entry*     e;
-    time_t     now;
-    Cache*     cache;
-
+/* Look the key up in its shard, and copy the answer out if there's an
+ * entry for it that can be served. *stale is set if that entry has expired
+ * and is only being served because of the cache's stale_ttl.
+ * The caller must keep the cache alive, by holding either
+ * _res_cache_list_lock or a read lock on _res_cache_rwlock.
+ */
+static ResolvCacheStatus
+_cache_lookup_shard( Cache*       cache,
+                     Entry*       key,
+                     void*        answer,
+                     int          answersize,
+                     int         *answerlen,
+                     int         *stale )
+{
+    CacheShard*        shard = &cache->shards[key->hash % CONFIG_CACHE_SHARDS];
+    Entry**            lookup;
+    Entry*             e;
+    time_t             now;
     ResolvCacheStatus  result = RESOLV_CACHE_NOTFOUND;
 
-    XLOG("%s: lookup", __FUNCTION__);
-    XLOG_QUERY(query, querylen);
-
-    /* we don't cache malformed queries */
-    if (!entry_init_key(key, query, querylen)) {
-        XLOG("%s: unsupported query", __FUNCTION__);
-        return RESOLV_CACHE_UNSUPPORTED;
-    }
-    /* lookup cache */
-    pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+    *stale = 0;
 
-    cache = _find_named_cache_locked(netid);
-    if (cache == NULL) {
-        result = RESOLV_CACHE_UNSUPPORTED;
+    pthread_mutex_lock(&shard->lock);
+    if (shard->max_entries == 0) {
         goto Exit;
     }
 
     /* see the description of _lookup_p to understand this.
      * the function always return a non-NULL pointer.
      */
-    lookup = _cache_lookup_p(cache, key);
+    lookup = _cache_lookup_p(shard, key);
     e      = *lookup;
 
     if (e == NULL) {
         XLOG( "NOT IN CACHE");
-        // calling thread will wait if an outstanding request is found
-        // that matching this query
-        if (!_cache_check_pending_request_locked(&cache, key, netid) || cache == NULL) {
-            goto Exit;
-        } else {
-            lookup = _cache_lookup_p(cache, key);
-            e = *lookup;
-            if (e == NULL) {
-                goto Exit;
-            }
-        }
+        goto Exit;
     }
 
-    now = _time_now();
-
     /* remove stale entries here */
-    if (now >= e->expires) {
+    now = _time_now();
+    if (now >= e->expires + __atomic_load_n(&cache->stale_ttl, __ATOMIC_RELAXED)) {
         XLOG( " NOT IN CACHE (STALE ENTRY %p DISCARDED)", *lookup );
         XLOG_QUERY(e->query, e->querylen);
-        _cache_remove_p(cache, lookup);
+        _cache_remove_p(shard, lookup);
         goto Exit;
     }
+    *stale = (now >= e->expires);
 
     *answerlen = e->answerlen;
     if (e->answerlen > answersize) {
@@ -1746,19 +1793,121 @@ _resolv_cache_lookup( unsigned              netid,
     memcpy( answer, e->answer, e->answerlen );
 
     /* bump up this entry to the top of the MRU list */
-    if (e != cache->mru_list.mru_next) {
+    if (e != shard->mru_list.mru_next) {
         entry_mru_remove( e );
-        entry_mru_add( e, &cache->mru_list );
+        entry_mru_add( e, &shard->mru_list );
     }
 
     XLOG( "FOUND IN CACHE entry=%p", e );
     result = RESOLV_CACHE_FOUND;
 
+Exit:
+    pthread_mutex_unlock(&shard->lock);
+    return result;
+}
+
+static ResolvCacheStatus
+_resolv_cache_lookup_impl( unsigned              netid,
+                           const void*           query,
+                           int                   querylen,
+                           void*                 answer,
+                           int                   answersize,
+                           int                  *answerlen,
+                           int                   wait )
+{
+    Entry      key[1];
+    Cache*     cache;
+    int        stale = 0;
+
+    ResolvCacheStatus  result = RESOLV_CACHE_NOTFOUND;
+
+    XLOG("%s: lookup", __FUNCTION__);
+    XLOG_QUERY(query, querylen);
+
+    /* we don't cache malformed queries */
+    if (!entry_init_key(key, query, querylen)) {
+        XLOG("%s: unsupported query", __FUNCTION__);
+        return RESOLV_CACHE_UNSUPPORTED;
+    }
+    pthread_once(&_res_cache_once, _res_cache_init);
+
+    /* a hit only needs the shard lock */
+    pthread_rwlock_rdlock(&_res_cache_rwlock);
+    cache = _find_named_cache_locked(netid);
+    if (cache == NULL) {
+        result = RESOLV_CACHE_UNSUPPORTED;
+    } else {
+        result = _cache_lookup_shard(cache, key, answer, answersize, answerlen, &stale);
+    }
+    pthread_rwlock_unlock(&_res_cache_rwlock);
+    if (result != RESOLV_CACHE_NOTFOUND && !stale) {
+        return result;
+    }
+
+    /* on a miss or a stale hit, check for another thread already asking the same question */
+    pthread_mutex_lock(&_res_cache_list_lock);
+
+    cache = _find_named_cache_locked(netid);
+    if (cache == NULL) {
+        result = RESOLV_CACHE_UNSUPPORTED;
+        goto Exit;
+    }
+
+    /* the answer may have been added since we looked */
+    result = _cache_lookup_shard(cache, key, answer, answersize, answerlen, &stale);
+    if (result == RESOLV_CACHE_FOUND && stale) {
+        /* serve the stale answer unless nobody is refreshing it yet,
+         * in which case this thread has just been made responsible */
+        if (_cache_find_pending_request_locked(cache, key) == NULL) {
+            XLOG( "STALE ENTRY, REFRESHING");
+            result = RESOLV_CACHE_NOTFOUND;
+        }
+        goto Exit;
+    }
+    if (result != RESOLV_CACHE_NOTFOUND) {
+        goto Exit;
+    }
+
+    if (!wait) {
+        // registers the calling thread as the sender if nobody else is
+        if (_cache_find_pending_request_locked(cache, key) != NULL) {
+            result = RESOLV_CACHE_PENDING;
+        }
+        goto Exit;
+    }
+
+    // calling thread will wait if an outstanding request is found
+    // that matching this query
+    if (_cache_check_pending_request_locked(&cache, key, netid) && cache != NULL) {
+        result = _cache_lookup_shard(cache, key, answer, answersize, answerlen, &stale);
+    }
+
 Exit:
     pthread_mutex_unlock(&_res_cache_list_lock);
     return result;
 }
 
+ResolvCacheStatus
+_resolv_cache_lookup( unsigned              netid,
+                      const void*           query,
+                      int                   querylen,
+                      void*                 answer,
+                      int                   answersize,
+                      int                  *answerlen )
+{
+    return _resolv_cache_lookup_impl(netid, query, querylen, answer, answersize, answerlen, 1);
+}
+
+ResolvCacheStatus
+_resolv_cache_lookup_nowait( unsigned              netid,
+                             const void*           query,
+                             int                   querylen,
+                             void*                 answer,
+                             int                   answersize,
+                             int                  *answerlen )
+{
+    return _resolv_cache_lookup_impl(netid, query, querylen, answer, answersize, answerlen, 0);
+}
 
 void
 _resolv_cache_add( unsigned              netid,
@@ -1767,11 +1916,12 @@ _resolv_cache_add( unsigned              netid,
                    const void*           answer,
                    int                   answerlen )
 {
-    Entry    key[1];
-    Entry*   e;
-    Entry**  lookup;
-    u_long   ttl;
-    Cache*   cache = NULL;
+    Entry        key[1];
+    Entry*       e;
+    Entry**      lookup;
+    u_long       ttl;
+    Cache*       cache = NULL;
+    CacheShard*  shard;
 
     /* don't assume that the query has already been cached
      */
@@ -1795,27 +1945,37 @@ _resolv_cache_add( unsigned              netid,
     XLOG_BYTES(answer,answerlen);
 #endif
 
-    lookup = _cache_lookup_p(cache, key);
+    shard = &cache->shards[key->hash % CONFIG_CACHE_SHARDS];
+    pthread_mutex_lock(&shard->lock);
+    if (shard->max_entries == 0) {
+        goto ExitShard;
+    }
+
+    lookup = _cache_lookup_p(shard, key);
     e      = *lookup;
 
-    if (e != NULL) { /* should not happen */
-        XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-             __FUNCTION__, e);
-        goto Exit;
+    if (e != NULL) {
+        if (_time_now() < e->expires) { /* should not happen */
+            XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
+                 __FUNCTION__, e);
+            goto ExitShard;
+        }
+        /* replace the stale entry being refreshed */
+        _cache_remove_p(shard, lookup);
     }
 
-    if (cache->num_entries >= cache->max_entries) {
-        _cache_remove_expired(cache);
-        if (cache->num_entries >= cache->max_entries) {
-            _cache_remove_oldest(cache);
+    if (shard->num_entries >= shard->max_entries) {
+        _cache_remove_expired(shard, __atomic_load_n(&cache->stale_ttl, __ATOMIC_RELAXED));
+        if (shard->num_entries >= shard->max_entries) {
+            _cache_remove_oldest(shard);
         }
         /* need to lookup again */
-        lookup = _cache_lookup_p(cache, key);
+        lookup = _cache_lookup_p(shard, key);
         e      = *lookup;
         if (e != NULL) {
             XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
                 __FUNCTION__, e);
-            goto Exit;
+            goto ExitShard;
         }
     }
 
@@ -1824,12 +1984,14 @@ _resolv_cache_add( unsigned              netid,
         e = entry_alloc(key, answer, answerlen);
         if (e != NULL) {
             e->expires = ttl + _time_now();
-            _cache_add_p(cache, lookup, e);
+            _cache_add_p(shard, lookup, e);
         }
     }
 #if DEBUG
-    _cache_dump_mru(cache);
+    _cache_dump_mru(shard);
 #endif
+ExitShard:
+    pthread_mutex_unlock(&shard->lock);
 Exit:
     if (cache != NULL) {
       _cache_notify_waiting_tid_locked(cache, key);
@@ -1872,6 +2034,7 @@ _res_cache_init(void)
 {
     memset(&_res_cache_list, 0, sizeof(_res_cache_list));
     pthread_mutex_init(&_res_cache_list_lock, NULL);
+    pthread_rwlock_init(&_res_cache_rwlock, NULL);
 }
 
 static struct resolv_cache*
@@ -1885,7 +2048,9 @@ _get_res_cache_for_net_locked(unsigned netid)
             if (cache) {
                 cache_info->cache = cache;
                 cache_info->netid = netid;
+                pthread_rwlock_wrlock(&_res_cache_rwlock);
                 _insert_cache_info_locked(cache_info);
+                pthread_rwlock_unlock(&_res_cache_rwlock);
             } else {
                 free(cache_info);
             }
@@ -1929,10 +2094,10 @@ void _resolv_delete_cache_for_net(unsigned netid)
         struct resolv_cache_info* cache_info = prev_cache_info->next;
 
         if (cache_info->netid == netid) {
+            pthread_rwlock_wrlock(&_res_cache_rwlock);
             prev_cache_info->next = cache_info->next;
-            _cache_flush_locked(cache_info->cache);
-            free(cache_info->cache->entries);
-            free(cache_info->cache);
+            pthread_rwlock_unlock(&_res_cache_rwlock);
+            _resolv_cache_free(cache_info->cache);
             _free_nameservers_locked(cache_info);
             free(cache_info);
             break;
@@ -1996,6 +2161,7 @@ _resolv_set_default_params(struct __res_params* params) {
     params->min_samples = 0;
     params->max_samples = 0;
     params->base_timeout_msec = 0;  // 0 = legacy algorithm
+    params->stale_ttl_sec = 0;
 }
 
 int
@@ -2011,6 +2177,10 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, unsigned n
         XLOG("%s: numservers=%u, MAXNS=%u", __FUNCTION__, numservers, MAXNS);
         return E2BIG;
     }
+    if (params != NULL && params->stale_ttl_sec < 0) {
+        XLOG("%s: stale_ttl_sec=%d", __FUNCTION__, params->stale_ttl_sec);
+        return EINVAL;
+    }
 
     // Parse the addresses before actually locking or changing any state, in case there is an error.
     // As a side effect this also reduces the time the lock is kept.
@@ -2048,6 +2218,11 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, unsigned n
         } else {
             _resolv_set_default_params(&cache_info->params);
         }
+        if (cache_info->params.stale_ttl_sec > MAX_STALE_TTL_SEC) {
+            cache_info->params.stale_ttl_sec = MAX_STALE_TTL_SEC;
+        }
+        __atomic_store_n(&cache_info->cache->stale_ttl, cache_info->params.stale_ttl_sec,
+                         __ATOMIC_RELAXED);
 
         if (!_resolv_is_nameservers_equal_locked(cache_info, servers, numservers)) {
             // free current before adding new
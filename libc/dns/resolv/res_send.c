@@ -134,6 +134,17 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #define EXT(res) ((res)->_u._ext)
 #define DBG 0
 
+/* One of the two queries handled by res_nsend_pair. */
+struct pair_query {
+	const u_char *buf;
+	int buflen;
+	u_char *ans;
+	int anssiz;
+	ResolvCacheStatus cache_status;
+	int resplen;
+	int done;
+};
+
 /* Forward. */
 
 static int		get_salen __P((const struct sockaddr *));
@@ -142,6 +153,11 @@ static int		send_vc(res_state, struct __res_params *params, const u_char *, int,
 				u_char *, int, int *, int, time_t *, int *, int *);
 static int		send_dg(res_state, struct __res_params *params, const u_char *, int,
 				u_char *, int, int *, int, int *, int *, time_t *, int *, int *);
+static int		open_dg(res_state, int *, int);
+static void		send_dg_pair(res_state, struct pair_query *);
+static int		res_nsend_uncached(res_state, const u_char *, int, u_char *, int,
+					   ResolvCacheStatus);
+static void		sync_nsaddrs(res_state);
 static void		Aerror(const res_state, FILE *, const char *, int,
 			       const struct sockaddr *, int);
 static void		Perror(const res_state, FILE *, const char *, int);
@@ -347,49 +363,15 @@ res_queriesmatch(const u_char *buf1, const u_char *eom1,
 	return (1);
 }
 
-int
-res_nsend(res_state statp,
-	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+/*
+ * If the ns_addr_list in the resolver context has changed, then
+ * invalidate our cached copy and the associated timing data.
+ */
+static void
+sync_nsaddrs(res_state statp)
 {
-	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
-	char abuf[NI_MAXHOST];
-	ResolvCacheStatus     cache_status = RESOLV_CACHE_UNSUPPORTED;
-
-	if (anssiz < HFIXEDSZ) {
-		errno = EINVAL;
-		return (-1);
-	}
-	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
-		(stdout, ";; res_send()\n"), buf, buflen);
-	v_circuit = (statp->options & RES_USEVC) || buflen > PACKETSZ;
-	gotsomewhere = 0;
-	terrno = ETIMEDOUT;
-
-	int  anslen = 0;
-	cache_status = _resolv_cache_lookup(
-			statp->netid, buf, buflen,
-			ans, anssiz, &anslen);
-
-	if (cache_status == RESOLV_CACHE_FOUND) {
-		return anslen;
-	} else if (cache_status != RESOLV_CACHE_UNSUPPORTED) {
-		// had a cache miss for a known network, so populate the thread private
-		// data so the normal resolve path can do its thing
-		_resolv_populate_res_for_net(statp);
-	}
-	if (statp->nscount == 0) {
-		// We have no nameservers configured, so there's no point trying.
-		// Tell the cache the query failed, or any retries and anyone else asking the same
-		// question will block for PENDING_REQUEST_TIMEOUT seconds instead of failing fast.
-		_resolv_cache_query_failed(statp->netid, buf, buflen);
-		errno = ESRCH;
-		return (-1);
-	}
+	int ns;
 
-	/*
-	 * If the ns_addr_list in the resolver context has changed, then
-	 * invalidate our cached copy and the associated timing data.
-	 */
 	if (EXT(statp).nscount != 0) {
 		int needclose = 0;
 		struct sockaddr_storage peer;
@@ -441,6 +423,148 @@ res_nsend(res_state statp,
 		}
 		EXT(statp).nscount = statp->nscount;
 	}
+}
+
+int
+res_nsend(res_state statp,
+	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+{
+	ResolvCacheStatus     cache_status = RESOLV_CACHE_UNSUPPORTED;
+
+	if (anssiz < HFIXEDSZ) {
+		errno = EINVAL;
+		return (-1);
+	}
+	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
+		(stdout, ";; res_send()\n"), buf, buflen);
+
+	int  anslen = 0;
+	cache_status = _resolv_cache_lookup(
+			statp->netid, buf, buflen,
+			ans, anssiz, &anslen);
+
+	if (cache_status == RESOLV_CACHE_FOUND) {
+		return anslen;
+	} else if (cache_status != RESOLV_CACHE_UNSUPPORTED) {
+		// had a cache miss for a known network, so populate the thread private
+		// data so the normal resolve path can do its thing
+		_resolv_populate_res_for_net(statp);
+	}
+	return res_nsend_uncached(statp, buf, buflen, ans, anssiz, cache_status);
+}
+
+/*
+ * Like two calls to res_nsend, but on a cache miss for both queries (in
+ * practice the AAAA and A queries for one name) they're sent to the first
+ * usable server at the same time over a single socket, so an AF_UNSPEC
+ * lookup costs one round trip rather than two. Whatever doesn't get a
+ * plain answer that way -- a timeout, an error, a truncated answer --
+ * goes through the normal path, with its retries and fallback to TCP.
+ * The result of each query, as res_nsend would return it, is left in
+ * *resplen1 and *resplen2.
+ *
+ * A cache miss makes this thread responsible for the query until its
+ * answer is added (or it fails), and other threads asking the same
+ * question wait for that. So each answer is added as soon as it arrives,
+ * and once the first query is ours we don't wait for another thread's
+ * copy of the second: if someone else is already sending it, we finish
+ * the first query alone and only then wait for theirs.
+ */
+void
+res_nsend_pair(res_state statp,
+	       const u_char *buf1, int buflen1, u_char *ans1, int anssiz1, int *resplen1,
+	       const u_char *buf2, int buflen2, u_char *ans2, int anssiz2, int *resplen2)
+{
+	struct pair_query q[2] = {
+		{ buf1, buflen1, ans1, anssiz1, RESOLV_CACHE_UNSUPPORTED, -1, 0 },
+		{ buf2, buflen2, ans2, anssiz2, RESOLV_CACHE_UNSUPPORTED, -1, 0 },
+	};
+	int i, missed = 0;
+
+	if (anssiz1 < HFIXEDSZ || anssiz2 < HFIXEDSZ) {
+		errno = EINVAL;
+		*resplen1 = *resplen2 = -1;
+		return;
+	}
+
+	for (i = 0; i < 2; i++) {
+		DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
+			(stdout, ";; res_send()\n"), q[i].buf, q[i].buflen);
+		if (i == 1 && q[0].cache_status == RESOLV_CACHE_NOTFOUND) {
+			q[i].cache_status = _resolv_cache_lookup_nowait(statp->netid,
+					q[i].buf, q[i].buflen, q[i].ans, q[i].anssiz,
+					&q[i].resplen);
+		} else {
+			q[i].cache_status = _resolv_cache_lookup(statp->netid,
+					q[i].buf, q[i].buflen, q[i].ans, q[i].anssiz,
+					&q[i].resplen);
+		}
+		if (q[i].cache_status == RESOLV_CACHE_FOUND) {
+			q[i].done = 1;
+		} else if (q[i].cache_status == RESOLV_CACHE_NOTFOUND) {
+			missed = 1;
+		}
+	}
+	if (missed) {
+		_resolv_populate_res_for_net(statp);
+	}
+
+	/*
+	 * Only the plain UDP case is worth doing in parallel. The hooks expect
+	 * to see one query at a time, and rotation would move to a different
+	 * server between the two queries anyway.
+	 */
+	if (!q[0].done && !q[1].done && q[1].cache_status != RESOLV_CACHE_PENDING &&
+	    statp->nscount > 0 &&
+	    statp->qhook == NULL && statp->rhook == NULL &&
+	    (statp->options & (RES_USEVC | RES_ROTATE)) == 0U &&
+	    buflen1 <= PACKETSZ && buflen2 <= PACKETSZ) {
+		send_dg_pair(statp, q);
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (q[i].done) {
+			continue;
+		}
+		if (q[i].cache_status == RESOLV_CACHE_PENDING) {
+			/* The first query is finished, so we can wait now. */
+			q[i].resplen = res_nsend(statp, q[i].buf, q[i].buflen,
+					q[i].ans, q[i].anssiz);
+		} else {
+			q[i].resplen = res_nsend_uncached(statp, q[i].buf, q[i].buflen,
+					q[i].ans, q[i].anssiz, q[i].cache_status);
+		}
+	}
+	*resplen1 = q[0].resplen;
+	*resplen2 = q[1].resplen;
+}
+
+/*
+ * Sends a query the cache couldn't answer. cache_status is what the cache
+ * lookup returned, and decides whether the answer is added to the cache.
+ */
+static int
+res_nsend_uncached(res_state statp,
+		   const u_char *buf, int buflen, u_char *ans, int anssiz,
+		   ResolvCacheStatus cache_status)
+{
+	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
+	char abuf[NI_MAXHOST];
+
+	v_circuit = (statp->options & RES_USEVC) || buflen > PACKETSZ;
+	gotsomewhere = 0;
+	terrno = ETIMEDOUT;
+
+	if (statp->nscount == 0) {
+		// We have no nameservers configured, so there's no point trying.
+		// Tell the cache the query failed, or any retries and anyone else asking the same
+		// question will block for PENDING_REQUEST_TIMEOUT seconds instead of failing fast.
+		_resolv_cache_query_failed(statp->netid, buf, buflen);
+		errno = ESRCH;
+		return (-1);
+	}
+
+	sync_nsaddrs(statp);
 
 	/*
 	 * Some resolvers want to even out the load on their nameservers.
@@ -1076,70 +1200,14 @@ send_dg(res_state statp, struct __res_params* params,
 	*delay = 0;
 	const HEADER *hp = (const HEADER *)(const void *)buf;
 	HEADER *anhp = (HEADER *)(void *)ans;
-	const struct sockaddr *nsap;
-	int nsaplen;
 	struct timespec now, timeout, finish, done;
 	struct sockaddr_storage from;
 	socklen_t fromlen;
 	int resplen, n, s;
 
-	nsap = get_nsaddr(statp, (size_t)ns);
-	nsaplen = get_salen(nsap);
-	if (EXT(statp).nssocks[ns] == -1) {
-		EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
-		if (EXT(statp).nssocks[ns] < 0) {
-			switch (errno) {
-			case EPROTONOSUPPORT:
-#ifdef EPFNOSUPPORT
-			case EPFNOSUPPORT:
-#endif
-			case EAFNOSUPPORT:
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (0);
-			default:
-				*terrno = errno;
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (-1);
-			}
-		}
-
-		fchown(EXT(statp).nssocks[ns], AID_DNS, -1);
-		if (statp->_mark != MARK_UNSET) {
-			if (setsockopt(EXT(statp).nssocks[ns], SOL_SOCKET,
-					SO_MARK, &(statp->_mark), sizeof(statp->_mark)) < 0) {
-				res_nclose(statp);
-				return -1;
-			}
-		}
-#ifndef CANNOT_CONNECT_DGRAM
-		/*
-		 * On a 4.3BSD+ machine (client and server,
-		 * actually), sending to a nameserver datagram
-		 * port with no nameserver will cause an
-		 * ICMP port unreachable message to be returned.
-		 * If our datagram socket is "connected" to the
-		 * server, we get an ECONNREFUSED error on the next
-		 * socket operation, and select returns if the
-		 * error message is received.  We can thus detect
-		 * the absence of a nameserver without timing out.
-		 */
-		if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
-			Aerror(statp, stderr, "bind(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
-			return (0);
-		}
-		if (__connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
-			Aerror(statp, stderr, "connect(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
-			return (0);
-		}
-#endif /* !CANNOT_CONNECT_DGRAM */
-		Dprint(statp->options & RES_DEBUG,
-		       (stdout, ";; new DG socket\n"))
-
-	}
+	n = open_dg(statp, terrno, ns);
+	if (n <= 0)
+		return (n);
 	s = EXT(statp).nssocks[ns];
 #ifndef CANNOT_CONNECT_DGRAM
 	if (send(s, (const char*)buf, (size_t)buflen, 0) != buflen) {
@@ -1148,6 +1216,8 @@ send_dg(res_state statp, struct __res_params* params,
 		return (0);
 	}
 #else /* !CANNOT_CONNECT_DGRAM */
+	const struct sockaddr *nsap = get_nsaddr(statp, (size_t)ns);
+	int nsaplen = get_salen(nsap);
 	if (sendto(s, (const char*)buf, buflen, 0, nsap, nsaplen) != buflen)
 	{
 		Aerror(statp, stderr, "sendto", errno, nsap, nsaplen);
@@ -1288,6 +1358,192 @@ retry:
 	return (resplen);
 }
 
+/*
+ * Opens (if it isn't already open) the datagram socket for server ns.
+ * Returns 1 on success, and otherwise what send_dg should return: 0 to
+ * move on to the next server, or -1 with *terrno set for a fatal error.
+ */
+static int
+open_dg(res_state statp, int *terrno, int ns)
+{
+	const struct sockaddr *nsap = get_nsaddr(statp, (size_t)ns);
+	int nsaplen = get_salen(nsap);
+
+	if (EXT(statp).nssocks[ns] == -1) {
+		EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (EXT(statp).nssocks[ns] < 0) {
+			switch (errno) {
+			case EPROTONOSUPPORT:
+#ifdef EPFNOSUPPORT
+			case EPFNOSUPPORT:
+#endif
+			case EAFNOSUPPORT:
+				Perror(statp, stderr, "socket(dg)", errno);
+				return (0);
+			default:
+				*terrno = errno;
+				Perror(statp, stderr, "socket(dg)", errno);
+				return (-1);
+			}
+		}
+
+		fchown(EXT(statp).nssocks[ns], AID_DNS, -1);
+		if (statp->_mark != MARK_UNSET) {
+			if (setsockopt(EXT(statp).nssocks[ns], SOL_SOCKET,
+					SO_MARK, &(statp->_mark), sizeof(statp->_mark)) < 0) {
+				res_nclose(statp);
+				return -1;
+			}
+		}
+#ifndef CANNOT_CONNECT_DGRAM
+		/*
+		 * On a 4.3BSD+ machine (client and server,
+		 * actually), sending to a nameserver datagram
+		 * port with no nameserver will cause an
+		 * ICMP port unreachable message to be returned.
+		 * If our datagram socket is "connected" to the
+		 * server, we get an ECONNREFUSED error on the next
+		 * socket operation, and select returns if the
+		 * error message is received.  We can thus detect
+		 * the absence of a nameserver without timing out.
+		 */
+		if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
+			Aerror(statp, stderr, "bind(dg)", errno, nsap,
+			    nsaplen);
+			res_nclose(statp);
+			return (0);
+		}
+		if (__connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
+			Aerror(statp, stderr, "connect(dg)", errno, nsap,
+			    nsaplen);
+			res_nclose(statp);
+			return (0);
+		}
+#endif /* !CANNOT_CONNECT_DGRAM */
+		Dprint(statp->options & RES_DEBUG,
+		       (stdout, ";; new DG socket\n"))
+
+	}
+	return (1);
+}
+
+/*
+ * The parallel half of res_nsend_pair: sends both queries to the first
+ * usable server and waits for their answers until that server's timeout.
+ * Marks the queries it got a usable answer for as done, and adds those
+ * answers to the cache; everything else is left for res_nsend_uncached.
+ */
+static void
+send_dg_pair(res_state statp, struct pair_query *q)
+{
+	struct __res_stats stats[MAXNS];
+	struct __res_params params;
+	bool usable_servers[MAXNS];
+	struct timespec now, finish, done;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int revision_id, terrno, ns, s, i, n, resplen, pending;
+	time_t at;
+
+	sync_nsaddrs(statp);
+	revision_id = _resolv_cache_get_resolver_stats(statp->netid, &params, stats);
+	android_net_res_stats_get_usable_servers(&params, stats, statp->nscount,
+		usable_servers);
+	for (ns = 0; ns < statp->nscount && !usable_servers[ns]; ns++)
+		continue;
+	if (ns == statp->nscount)
+		return;
+
+	statp->_flags &= ~RES_F_LASTMASK;
+	statp->_flags |= (ns << RES_F_LASTSHIFT);
+	if (open_dg(statp, &terrno, ns) <= 0)
+		return;
+	s = EXT(statp).nssocks[ns];
+
+	at = time(NULL);
+	for (i = 0; i < 2; i++) {
+		if (send(s, (const char*)q[i].buf, (size_t)q[i].buflen, 0) != q[i].buflen) {
+			Perror(statp, stderr, "send", errno);
+			res_nclose(statp);
+			return;
+		}
+	}
+
+	now = evNowTime();
+	finish = evAddTime(now, get_timeout(statp, &params, ns));
+	pending = 2;
+	while (pending > 0) {
+		/* Receive into the buffer of the first query still waiting. */
+		struct pair_query *rq = q[0].done ? &q[1] : &q[0];
+		HEADER *anhp = (HEADER *)(void *)rq->ans;
+
+		n = retrying_poll(s, POLLIN, &finish);
+		if (n <= 0) {
+			if (n < 0) {
+				Perror(statp, stderr, "poll", errno);
+				res_nclose(statp);
+			}
+			break;
+		}
+		fromlen = sizeof(from);
+		resplen = recvfrom(s, (char*)rq->ans, (size_t)rq->anssiz, 0,
+				   (struct sockaddr *)(void *)&from, &fromlen);
+		if (resplen < HFIXEDSZ) {
+			Perror(statp, stderr, "recvfrom", errno);
+			res_nclose(statp);
+			break;
+		}
+		if (!(statp->options & RES_INSECURE1) &&
+		    !res_ourserver_p(statp, (struct sockaddr *)(void *)&from))
+			continue;
+		for (i = 0; i < 2; i++) {
+			const HEADER *hp = (const HEADER *)(const void *)q[i].buf;
+			if (!q[i].done && hp->id == anhp->id &&
+			    ((statp->options & RES_INSECURE2) ||
+			     res_queriesmatch(q[i].buf, q[i].buf + q[i].buflen,
+					      rq->ans, rq->ans + resplen)))
+				break;
+		}
+		if (i == 2)
+			continue;	/* an answer to some earlier query */
+		pending--;
+
+		/*
+		 * Errors and truncated answers need the retry logic in
+		 * res_nsend_uncached, so stop waiting for this one.
+		 */
+		if (anhp->rcode == SERVFAIL || anhp->rcode == NOTIMP ||
+		    anhp->rcode == REFUSED || anhp->rcode == FORMERR ||
+		    (!(statp->options & RES_IGNTC) && anhp->tc))
+			continue;
+		if (&q[i] != rq) {
+			if (resplen > q[i].anssiz)
+				continue;
+			memcpy(q[i].ans, rq->ans, (size_t)resplen);
+		}
+
+		struct __res_sample sample;
+		done = evNowTime();
+		_res_stats_set_sample(&sample, at, anhp->rcode,
+			_res_stats_calculate_rtt(&done, &now));
+		_resolv_cache_add_resolver_stats_sample(statp->netid, revision_id,
+			ns, &sample, params.max_samples);
+
+		if (q[i].cache_status == RESOLV_CACHE_NOTFOUND) {
+			_resolv_cache_add(statp->netid, q[i].buf, q[i].buflen,
+					  q[i].ans, resplen);
+		}
+		q[i].resplen = resplen;
+		q[i].done = 1;
+	}
+	if (DBG) {
+		async_safe_format_log(ANDROID_LOG_DEBUG, "libc",
+			"send_dg_pair answered %d of 2\n", q[0].done + q[1].done);
+	}
+	if ((statp->options & RES_STAYOPEN) == 0U)
+		res_nclose(statp);
+}
+
 static void
 Aerror(const res_state statp, FILE *file, const char *string, int error,
        const struct sockaddr *address, int alen)
@@ -47,6 +47,12 @@ enum {
   PTHREAD_MUTEX_NORMAL = 0,
   PTHREAD_MUTEX_RECURSIVE = 1,
   PTHREAD_MUTEX_ERRORCHECK = 2,
+  /**
+   * A normal mutex that spins for a while before sleeping when it's contended.
+   * pthread_mutexattr_settype() only accepts this since API level 36;
+   * earlier releases return EINVAL.
+   */
+  PTHREAD_MUTEX_ADAPTIVE_NP = 3,
 
   PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
   PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
@@ -57,6 +63,9 @@ enum {
 #define PTHREAD_MUTEX_INITIALIZER { { ((PTHREAD_MUTEX_NORMAL & 3) << 14) } }
 #define PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_RECURSIVE & 3) << 14) } }
 #define PTHREAD_ERRORCHECK_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_ERRORCHECK & 3) << 14) } }
+#if __ANDROID_API__ >= 36
+#define PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_NORMAL & 3) << 14) | (1 << 12) } }
+#endif
 
 #define PTHREAD_COND_INITIALIZER  { { 0 } }
 #define PTHREAD_COND_INITIALIZER_MONOTONIC_NP  { { 1 << 1 } }
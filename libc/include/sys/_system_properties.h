@@ -122,6 +122,55 @@ int __system_property_update(prop_info* _Nonnull __pi, const char* _Nonnull __va
 */
 uint32_t __system_property_serial(const prop_info* _Nonnull __pi);
 
+/* Read the values of `__count` properties returned by
+** __system_property_find as a consistent snapshot: no call to
+** __system_property_update or __system_property_add completes between
+** reading the first property and reading the last. The value of
+** `__pis[i]` is copied to `__values[i]` as by __system_property_read,
+** and its serial number to `__serials[i]` if `__serials` is non-null.
+**
+** Returns 0 on success, -1 on error.
+*/
+int __system_property_read_batch(const prop_info* _Nonnull const* _Nonnull __pis, size_t __count, char (* _Nonnull __values)[PROP_VALUE_MAX], uint32_t* _Nullable __serials);
+
+/* Wait for any of the `__count` properties in `__pis` to be updated
+** past the corresponding serial number in `__old_serials`, for no
+** longer than `__relative_timeout`, or forever if it is null.
+** Unlike looping on __system_property_wait_any, updates to other
+** properties don't wake the caller (on Linux 5.16 and later).
+** `__count` must be between 1 and 128.
+**
+** Returns true and stores the current serial number of every property
+** in `__new_serials` if any changed, or false on timeout or error.
+*/
+bool __system_property_wait_multiple(const prop_info* _Nonnull const* _Nonnull __pis, const uint32_t* _Nonnull __old_serials, size_t __count, uint32_t* _Nonnull __new_serials, const struct timespec* _Nullable __relative_timeout);
+
+/* Per-context statistics for __system_properties_foreach_context. */
+typedef struct prop_context_stats {
+  /* The SELinux context of this property area. */
+  const char* _Nonnull context;
+  /* The size of this process' mapping of the area, or 0 if it isn't mapped. */
+  size_t mapped_size;
+  /* How many times this process has mapped the area. */
+  uint32_t map_count;
+  /* How many property lookups this process has made in the area,
+  ** including those answered from the __system_property_find cache. */
+  uint32_t lookup_count;
+  /* How much of the area has been allocated to properties so far, and how
+  ** much could be. Both are 0 if the area isn't mapped. Space is never
+  ** reclaimed, so __system_property_add fails once these are equal. */
+  uint32_t bytes_used;
+  uint32_t bytes_total;
+} prop_context_stats;
+
+/* For debugging: call `__callback` with the statistics for each property
+** context (and so each property area) this process knows about. Nothing
+** is reported for legacy devices that only have a single property area.
+**
+** Returns 0 on success, -1 on error.
+*/
+int __system_properties_foreach_context(void (* _Nonnull __callback)(const prop_context_stats* _Nonnull __stats, void* _Nullable __cookie), void* _Nullable __cookie);
+
 /* Initialize the system properties area in read only mode.
  * Should be done by all processes that need to read system
  * properties.
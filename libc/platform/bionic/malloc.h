@@ -111,6 +111,18 @@ enum {
   //   arg_size = sizeof(bool)
   M_GET_DECAY_TIME_ENABLED = 12,
 #define M_GET_DECAY_TIME_ENABLED M_GET_DECAY_TIME_ENABLED
+  // Start, reconfigure or stop a background thread that returns free heap
+  // memory to the kernel while the process is idle. Whenever allocation
+  // activity has settled and the allocator holds more than the target number
+  // of free but still resident bytes, the thread issues a single incremental
+  // M_PURGE, so no purge ever lands on a caller's allocation path. Only
+  // jemalloc reports that figure (its dirty and muzzy pages); with other
+  // allocators the target is ignored, and the thread purges once each time
+  // the heap settles after changing. Passing SIZE_MAX stops the thread.
+  //   arg = size_t*
+  //   arg_size = sizeof(size_t)
+  M_SET_BACKGROUND_PURGE_TARGET = 13,
+#define M_SET_BACKGROUND_PURGE_TARGET M_SET_BACKGROUND_PURGE_TARGET
 };
 
 #pragma clang diagnostic push
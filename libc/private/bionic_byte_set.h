@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+// A set of bytes, as a 256-bit bitmap laid out for nibble lookups: byte c is
+// in the set if bit ((c >> 4) & 7) of low[c & 0xf] (for c < 0x80) or of
+// high[c & 0xf] (for c >= 0x80) is set. That lets a 16-byte shuffle (pshufb
+// or tbl) find the bitmap row for every byte of a vector at once.
+struct ByteSet {
+  uint8_t low[16];
+  uint8_t high[16];
+
+  // Sets are built from a NUL-terminated string, so NUL is only ever in the
+  // set if it's added explicitly.
+  explicit ByteSet(const char* bytes) : low(), high() {
+    for (const uint8_t* p = reinterpret_cast<const uint8_t*>(bytes); *p != 0; ++p) Add(*p);
+  }
+
+  void Add(uint8_t c) { ((c < 0x80) ? low : high)[c & 0xf] |= 1 << ((c >> 4) & 7); }
+
+  bool Contains(uint8_t c) const {
+    return (((c < 0x80) ? low : high)[c & 0xf] >> ((c >> 4) & 7)) & 1;
+  }
+};
+
+// Vector operations for ByteSetSearch. Shuffle() has pshufb semantics: each
+// byte of the result is table[index & 0xf], or 0 if the top bit of the index
+// is set. Load() is only ever used on kBlock-aligned addresses, so it can't
+// cross into an unmapped page (or an MTE granule) the string doesn't use.
+#if defined(__aarch64__)
+struct NeonByteSetOps {
+  typedef uint8x16_t V;
+  static constexpr size_t kBlock = 16;
+  static constexpr int kShift = 2;
+
+  static V Splat(uint8_t c) { return vdupq_n_u8(c); }
+  static V Load(const uint8_t* p) { return vld1q_u8(p); }
+  static V LoadTable(const uint8_t* table) { return vld1q_u8(table); }
+  static V Shuffle(V table, V index) {
+    return vqtbl1q_u8(table, vandq_u8(index, vdupq_n_u8(0x8f)));
+  }
+  static V HighNibbles(V v) { return vshrq_n_u8(v, 4); }
+  static V Equal(V a, V b) { return vceqq_u8(a, b); }
+  static V And(V a, V b) { return vandq_u8(a, b); }
+  static V Or(V a, V b) { return vorrq_u8(a, b); }
+  static V Xor(V a, V b) { return veorq_u8(a, b); }
+  static uint64_t ToMask(V v) {
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ULL;
+  }
+};
+#elif defined(__SSSE3__)
+struct Ssse3ByteSetOps {
+  typedef __m128i V;
+  static constexpr size_t kBlock = 16;
+  static constexpr int kShift = 0;
+
+  static V Splat(uint8_t c) { return _mm_set1_epi8(c); }
+  static V Load(const uint8_t* p) { return _mm_load_si128(reinterpret_cast<const V*>(p)); }
+  static V LoadTable(const uint8_t* table) {
+    return _mm_loadu_si128(reinterpret_cast<const V*>(table));
+  }
+  static V Shuffle(V table, V index) { return _mm_shuffle_epi8(table, index); }
+  static V HighNibbles(V v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0xf)); }
+  static V Equal(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+  static V And(V a, V b) { return _mm_and_si128(a, b); }
+  static V Or(V a, V b) { return _mm_or_si128(a, b); }
+  static V Xor(V a, V b) { return _mm_xor_si128(a, b); }
+  static uint64_t ToMask(V v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+};
+#endif
+
+// strspn, strcspn and strpbrk, classifying a block of bytes at a time with
+// the nibble lookup from Wojciech Muła's "SIMD-ized strspn": one shuffle of
+// each half of the bitmap finds each byte's row, a third shuffle finds the
+// bit for its high nibble, and a compare tells whether that bit is set.
+template <typename Ops>
+class ByteSetSearch {
+ public:
+  static size_t Strspn(const char* s, const char* accept) {
+    if (accept[0] == '\0') return 0;
+    if (accept[1] == '\0') {
+      const char* p = s;
+      while (*p == accept[0]) ++p;
+      return p - s;
+    }
+    return Span<false>(s, ByteSet(accept));
+  }
+
+  static size_t Strcspn(const char* s, const char* reject) {
+    if (reject[0] == '\0') return strlen(s);
+    if (reject[1] == '\0') return strchrnul(s, reject[0]) - s;
+    ByteSet set(reject);
+    set.Add('\0');
+    return Span<true>(s, set);
+  }
+
+  static char* Strpbrk(const char* s, const char* accept) {
+    s += Strcspn(s, accept);
+    return (*s != '\0') ? const_cast<char*>(s) : nullptr;
+  }
+
+ private:
+  typedef typename Ops::V V;
+
+  // Returns the index of the first byte of s that is (if kInSet) or isn't in
+  // the set. The set must contain NUL if kInSet, and must not otherwise, so
+  // that the search stops at the end of the string either way.
+  template <bool kInSet>
+  static size_t Span(const char* s, const ByteSet& set) {
+    static constexpr uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                          1, 2, 4, 8, 16, 32, 64, 128};
+    const V low = Ops::LoadTable(set.low);
+    const V high = Ops::LoadTable(set.high);
+    const V bits = Ops::LoadTable(kBits);
+    const V top_bit = Ops::Splat(0x80);
+    const V zero = Ops::Splat(0);
+
+    auto stop_mask = [&](const uint8_t* p) -> uint64_t {
+      V bytes = Ops::Load(p);
+      V row = Ops::Or(Ops::Shuffle(low, bytes), Ops::Shuffle(high, Ops::Xor(bytes, top_bit)));
+      V bit = Ops::Shuffle(bits, Ops::HighNibbles(bytes));
+      return Ops::ToMask(Ops::Equal(Ops::And(row, bit), kInSet ? bit : zero));
+    };
+
+    // Start from the aligned block containing s, ignoring the bytes before s.
+    uintptr_t offset = reinterpret_cast<uintptr_t>(s) & (Ops::kBlock - 1);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s) - offset;
+    uint64_t mask = stop_mask(p) >> (offset << Ops::kShift);
+    if (mask != 0) return __builtin_ctzll(mask) >> Ops::kShift;
+    while (true) {
+      p += Ops::kBlock;
+      mask = stop_mask(p);
+      if (mask != 0) {
+        return (p - reinterpret_cast<const uint8_t*>(s)) + (__builtin_ctzll(mask) >> Ops::kShift);
+      }
+    }
+  }
+};
+
+// The same thing a byte at a time, for architectures without a suitable
+// shuffle. This is still much faster than searching the set for every byte.
+class ScalarByteSetSearch {
+ public:
+  static size_t Strspn(const char* s, const char* accept) {
+    return Span<false>(s, ByteSet(accept));
+  }
+
+  static size_t Strcspn(const char* s, const char* reject) {
+    ByteSet set(reject);
+    set.Add('\0');
+    return Span<true>(s, set);
+  }
+
+  static char* Strpbrk(const char* s, const char* accept) {
+    s += Strcspn(s, accept);
+    return (*s != '\0') ? const_cast<char*>(s) : nullptr;
+  }
+
+ private:
+  template <bool kInSet>
+  static size_t Span(const char* s, const ByteSet& set) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+    while (set.Contains(*p) != kInSet) ++p;
+    return p - reinterpret_cast<const uint8_t*>(s);
+  }
+};
+
+#if defined(__aarch64__)
+typedef ByteSetSearch<NeonByteSetOps> DefaultByteSetSearch;
+#elif defined(__SSSE3__)
+typedef ByteSetSearch<Ssse3ByteSetOps> DefaultByteSetSearch;
+#else
+typedef ScalarByteSetSearch DefaultByteSetSearch;
+#endif
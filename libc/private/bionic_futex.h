@@ -30,10 +30,12 @@
 
 #include <errno.h>
 #include <linux/futex.h>
+#include <linux/time_types.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <sys/cdefs.h>
 #include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 struct timespec;
@@ -70,6 +72,27 @@ static inline int __futex_wait_ex(volatile void* ftx, bool shared, int value) {
 __LIBC_HIDDEN__ int __futex_wait_ex(volatile void* ftx, bool shared, int value,
                                     bool use_realtime_clock, const timespec* abs_timeout);
 
+// Waits on up to FUTEX_WAITV_MAX futexes at once, until one is woken or the CLOCK_MONOTONIC
+// `abs_timeout` passes. Returns the index of a woken futex, or a negated errno: -EAGAIN if a
+// futex didn't have its expected value, -ETIMEDOUT, or -ENOSYS before Linux 5.16.
+static inline int __futex_waitv(futex_waitv* waiters, unsigned int count,
+                                const timespec* abs_timeout) {
+  // The kernel always wants a 64-bit timespec here, even for LP32.
+  __kernel_timespec kernel_timeout;
+  if (abs_timeout != nullptr) {
+    kernel_timeout.tv_sec = abs_timeout->tv_sec;
+    kernel_timeout.tv_nsec = abs_timeout->tv_nsec;
+  }
+  int saved_errno = errno;
+  int result = syscall(__NR_futex_waitv, waiters, count, 0,
+                       abs_timeout != nullptr ? &kernel_timeout : nullptr, CLOCK_MONOTONIC);
+  if (__predict_false(result == -1)) {
+    result = -errno;
+    errno = saved_errno;
+  }
+  return result;
+}
+
 static inline int __futex_pi_unlock(volatile void* ftx, bool shared) {
   return __futex(ftx, shared ? FUTEX_UNLOCK_PI : FUTEX_UNLOCK_PI_PRIVATE, 0, nullptr, 0);
 }
@@ -150,6 +150,10 @@ __LIBC_HIDDEN__ void __libc_init_malloc(libc_globals* globals);
 __LIBC_HIDDEN__ void __libc_init_setjmp_cookie(libc_globals* globals);
 __LIBC_HIDDEN__ void __libc_init_vdso(libc_globals* globals);
 
+#if defined(__x86_64__)
+__LIBC_HIDDEN__ void __libc_init_cache_info();
+#endif
+
 #if defined(__i386__)
 __LIBC_HIDDEN__ extern void* __libc_sysinfo;
 extern "C" __LIBC_HIDDEN__ void __libc_int0x80();
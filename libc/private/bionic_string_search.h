@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+// The upstream OpenBSD memmem, built under this name (see
+// libc_openbsd_large_stack in Android.bp). Two-Way is linear in the worst
+// case, but it's slower than the filter below on typical inputs, so it's
+// only used once the filter has stopped paying for itself.
+extern "C" void* __memmem_two_way(const void*, size_t, const void*, size_t);
+
+// Portable implementation of the operations StringSearch needs, eight bytes
+// at a time in a uint64_t. Equal() leaves the top bit of each byte that
+// matches set, and ToMask() moves those down to bit 0 of each byte.
+struct ScalarSearchOps {
+  typedef uint64_t V;
+  static constexpr size_t kBlock = 8;
+  static constexpr int kShift = 3;
+
+  static V Splat(uint8_t c) { return c * 0x0101010101010101ULL; }
+  static V Load(const uint8_t* p) {
+    V v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  static V Equal(V a, V b) {
+    constexpr V kLow7 = 0x7f7f7f7f7f7f7f7fULL;
+    V x = a ^ b;
+    // The top bit of each byte is clear only if the whole byte is zero. This
+    // is exact (unlike the usual "has a zero byte" trick) because the low
+    // seven bits can't carry into the neighboring byte.
+    return ~(((x & kLow7) + kLow7) | x | kLow7);
+  }
+  static V And(V a, V b) { return a & b; }
+  static V Or(V a, V b) { return a | b; }
+  static uint64_t ToMask(V v) { return v >> 7; }
+};
+
+#if defined(__aarch64__)
+struct NeonSearchOps {
+  typedef uint8x16_t V;
+  static constexpr size_t kBlock = 16;
+  static constexpr int kShift = 2;
+
+  static V Splat(uint8_t c) { return vdupq_n_u8(c); }
+  static V Load(const uint8_t* p) { return vld1q_u8(p); }
+  static V Equal(V a, V b) { return vceqq_u8(a, b); }
+  static V And(V a, V b) { return vandq_u8(a, b); }
+  static V Or(V a, V b) { return vorrq_u8(a, b); }
+  // There's no movemask on arm64, but narrowing with a shift gives four bits
+  // per byte, which is just as good.
+  static uint64_t ToMask(V v) {
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ULL;
+  }
+};
+typedef NeonSearchOps DefaultSearchOps;
+#elif defined(__i386__) || defined(__x86_64__)
+struct Sse2SearchOps {
+  typedef __m128i V;
+  static constexpr size_t kBlock = 16;
+  static constexpr int kShift = 0;
+
+  static V Splat(uint8_t c) { return _mm_set1_epi8(c); }
+  static V Load(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const V*>(p)); }
+  static V Equal(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+  static V And(V a, V b) { return _mm_and_si128(a, b); }
+  static V Or(V a, V b) { return _mm_or_si128(a, b); }
+  static uint64_t ToMask(V v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+};
+typedef Sse2SearchOps DefaultSearchOps;
+#else
+typedef ScalarSearchOps DefaultSearchOps;
+#endif
+
+// memmem, strstr and strcasestr, using the "generic SIMD" algorithm from
+// Wojciech Muła's "SIMD-friendly algorithms for substring searching": for a
+// block of kBlock possible starting positions at once, compare the byte at
+// each one with the first byte of the needle and the byte needle_size - 1
+// further on with the last byte of the needle, and only compare the rest of
+// the needle where both match.
+//
+// Ops supplies a vector type V of kBlock bytes, and ToMask() turns a vector
+// of byte comparisons into a bit mask with bit (i << kShift) set if byte i
+// matched, and no other bits set.
+template <typename Ops>
+class StringSearch {
+ public:
+  static void* Memmem(const void* haystack, size_t haystack_size, const void* needle,
+                      size_t needle_size) {
+    if (needle_size == 0) return const_cast<void*>(haystack);
+    if (needle_size > haystack_size) return nullptr;
+    const uint8_t* n = static_cast<const uint8_t*>(needle);
+    if (needle_size == 1) return const_cast<void*>(memchr(haystack, n[0], haystack_size));
+    return const_cast<uint8_t*>(
+        Search<false>(static_cast<const uint8_t*>(haystack), haystack_size, n, needle_size));
+  }
+
+  static char* Strstr(const char* haystack, const char* needle) {
+    return Find<false>(haystack, needle);
+  }
+
+  // Like OpenBSD's strcasestr (and tolower(3) in bionic), this only folds
+  // ASCII letters.
+  static char* Strcasestr(const char* haystack, const char* needle) {
+    return Find<true>(haystack, needle);
+  }
+
+ private:
+  typedef typename Ops::V V;
+
+  static bool IsLower(uint8_t c) { return static_cast<unsigned>(c - 'a') < 26; }
+  static uint8_t Fold(uint8_t c) { return IsLower(c | 0x20) ? (c | 0x20) : c; }
+  static uint8_t OtherCase(uint8_t c) { return IsLower(c | 0x20) ? (c ^ 0x20) : c; }
+
+  template <bool kIgnoreCase>
+  static bool SameByte(uint8_t a, uint8_t b) {
+    return kIgnoreCase ? Fold(a) == Fold(b) : a == b;
+  }
+
+  template <bool kIgnoreCase>
+  static bool SameBytes(const uint8_t* a, const uint8_t* b, size_t n) {
+    if (!kIgnoreCase) return memcmp(a, b, n) == 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (Fold(a[i]) != Fold(b[i])) return false;
+    }
+    return true;
+  }
+
+  template <bool kIgnoreCase>
+  static V Matches(V bytes, V c, V other_case) {
+    V result = Ops::Equal(bytes, c);
+    if (kIgnoreCase) result = Ops::Or(result, Ops::Equal(bytes, other_case));
+    return result;
+  }
+
+  // Returns the first occurrence of the needle in the haystack, or null.
+  // Requires 0 < needle_size <= haystack_size.
+  template <bool kIgnoreCase>
+  static const uint8_t* Search(const uint8_t* h, size_t haystack_size, const uint8_t* n,
+                               size_t needle_size) {
+    const size_t last = needle_size - 1;
+    const V first_byte = Ops::Splat(n[0]);
+    const V first_other = Ops::Splat(OtherCase(n[0]));
+    const V last_byte = Ops::Splat(n[last]);
+    const V last_other = Ops::Splat(OtherCase(n[last]));
+
+    size_t i = 0;
+    size_t work = 0;
+    while (i + last + Ops::kBlock <= haystack_size) {
+      V candidates = Ops::And(Matches<kIgnoreCase>(Ops::Load(h + i), first_byte, first_other),
+                              Matches<kIgnoreCase>(Ops::Load(h + i + last), last_byte, last_other));
+      for (uint64_t mask = Ops::ToMask(candidates); mask != 0; mask &= mask - 1) {
+        const uint8_t* p = h + i + (__builtin_ctzll(mask) >> Ops::kShift);
+        if (SameBytes<kIgnoreCase>(p + 1, n + 1, last)) return p;
+        work += needle_size;
+      }
+      i += Ops::kBlock;
+      // Something like "aaa...ab" in a haystack of 'a's makes every position
+      // a candidate, which is quadratic. Switch to Two-Way well before that
+      // costs more than a few passes over the haystack.
+      if (work > 4 * i + 1024) {
+        if (kIgnoreCase) return FoldedTwoWay(h + i, haystack_size - i, n, needle_size);
+        return static_cast<const uint8_t*>(
+            __memmem_two_way(h + i, haystack_size - i, n, needle_size));
+      }
+    }
+
+    // Less than a block of starting positions left.
+    for (; i + last < haystack_size; ++i) {
+      if (SameByte<kIgnoreCase>(h[i], n[0]) && SameByte<kIgnoreCase>(h[i + last], n[last]) &&
+          SameBytes<kIgnoreCase>(h + i + 1, n + 1, last)) {
+        return h + i;
+      }
+    }
+    return nullptr;
+  }
+
+  // Computes the maximal suffix of the folded needle under one ordering of
+  // bytes or the other, returning its start minus one (so SIZE_MAX for the
+  // whole needle) and its period.
+  static size_t MaximalSuffix(const uint8_t* n, size_t needle_size, bool reversed,
+                              size_t* period) {
+    size_t ip = SIZE_MAX;  // The start of the suffix, minus one.
+    size_t jp = 0;
+    size_t k = 1;
+    size_t p = 1;
+    while (jp + k < needle_size) {
+      uint8_t a = Fold(n[ip + k]);
+      uint8_t b = Fold(n[jp + k]);
+      if (a == b) {
+        if (k == p) {
+          jp += p;
+          k = 1;
+        } else {
+          ++k;
+        }
+      } else if (reversed ? (a < b) : (a > b)) {
+        jp += k;
+        k = 1;
+        p = jp - ip;
+      } else {
+        ip = jp++;
+        k = p = 1;
+      }
+    }
+    *period = p;
+    return ip;
+  }
+
+  // Crochemore and Perrin's Two-Way algorithm, comparing folded bytes. This
+  // is the ignore-case counterpart of __memmem_two_way, without its
+  // bad-character shift table: it only runs on inputs the filter has already
+  // found to be pathological, where linear time is what matters.
+  // Requires 0 < needle_size <= haystack_size.
+  static const uint8_t* FoldedTwoWay(const uint8_t* h, size_t haystack_size, const uint8_t* n,
+                                     size_t needle_size) {
+    // The critical factorization: n[0..ms] and n[ms + 1..].
+    size_t p;
+    size_t p_reversed;
+    size_t ms = MaximalSuffix(n, needle_size, false, &p);
+    size_t ms_reversed = MaximalSuffix(n, needle_size, true, &p_reversed);
+    if (ms_reversed + 1 > ms + 1) {
+      ms = ms_reversed;
+      p = p_reversed;
+    }
+
+    // If the left half repeats with period p, a mismatch in the right half
+    // lets us skip by p while remembering how much of the needle is already
+    // known to match. Otherwise we can skip past the whole left half.
+    size_t memory_after_shift;
+    if (SameBytes<true>(n, n + p, ms + 1)) {
+      memory_after_shift = needle_size - p;
+    } else {
+      memory_after_shift = 0;
+      p = ((ms > needle_size - ms - 1) ? ms : needle_size - ms - 1) + 1;
+    }
+
+    size_t memory = 0;
+    const uint8_t* end = h + haystack_size;
+    while (static_cast<size_t>(end - h) >= needle_size) {
+      // Compare the right half, left to right.
+      size_t k = (ms + 1 > memory) ? ms + 1 : memory;
+      while (k < needle_size && Fold(n[k]) == Fold(h[k])) ++k;
+      if (k < needle_size) {
+        h += k - ms;
+        memory = 0;
+        continue;
+      }
+      // Compare the left half, right to left.
+      for (k = ms + 1; k > memory && Fold(n[k - 1]) == Fold(h[k - 1]); --k) {
+      }
+      if (k <= memory) return h;
+      h += p;
+      memory = memory_after_shift;
+    }
+    return nullptr;
+  }
+
+  template <bool kIgnoreCase>
+  static char* Find(const char* haystack, const char* needle) {
+    size_t needle_size = strlen(needle);
+    if (needle_size == 0) return const_cast<char*>(haystack);
+    if (!kIgnoreCase && needle_size == 1) return const_cast<char*>(strchr(haystack, needle[0]));
+
+    // Searching only once we've found the end of the haystack would make a
+    // match near the start of a long string as slow as one at the end, so we
+    // find the length a window at a time, and search each window as we go.
+    const uint8_t* h = reinterpret_cast<const uint8_t*>(haystack);
+    const uint8_t* n = reinterpret_cast<const uint8_t*>(needle);
+    size_t window = (needle_size < 128) ? 256 : 2 * needle_size;
+    size_t start = 0;
+    size_t length = 0;
+    while (true) {
+      size_t more = strnlen(haystack + length, window);
+      length += more;
+      if (length - start >= needle_size) {
+        const uint8_t* result = Search<kIgnoreCase>(h + start, length - start, n, needle_size);
+        if (result != nullptr) return const_cast<char*>(reinterpret_cast<const char*>(result));
+        // Matches that start in this window but run past its end are still possible.
+        start = length - needle_size + 1;
+      }
+      if (more < window) return nullptr;
+      window *= 2;
+    }
+  }
+};
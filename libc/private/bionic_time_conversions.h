@@ -65,7 +65,6 @@ static inline int check_timespec(const timespec* ts, bool null_allowed) {
   return 0;
 }
 
-#if !defined(__LP64__)
 static inline void absolute_timespec_from_timespec(timespec& abs_ts, const timespec& ts, clockid_t clock) {
   clock_gettime(clock, &abs_ts);
   abs_ts.tv_sec += ts.tv_sec;
@@ -75,6 +74,5 @@ static inline void absolute_timespec_from_timespec(timespec& abs_ts, const times
     abs_ts.tv_sec++;
   }
 }
-#endif
 
 #endif
@@ -42,6 +42,9 @@
 #endif
 #if defined(__i386__) || defined(__x86_64__)
 #define VDSO_TIME_SYMBOL "__vdso_time"
+// The other architectures either don't have getcpu in the vdso, or (riscv64)
+// only have one that makes the system call anyway.
+#define VDSO_GETCPU_SYMBOL "__vdso_getcpu"
 #endif
 
 struct vdso_entry {
@@ -58,6 +61,9 @@ enum {
 #endif
 #if defined(VDSO_RISCV_HWPROBE_SYMBOL)
   VDSO_RISCV_HWPROBE,
+#endif
+#if defined(VDSO_GETCPU_SYMBOL)
+  VDSO_GETCPU,
 #endif
   VDSO_END
 };
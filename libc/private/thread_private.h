@@ -5,6 +5,7 @@
 #pragma once
 
 #include <pthread.h>
+#include <stdbool.h>
 
 __BEGIN_DECLS
 
@@ -32,4 +33,11 @@ __LIBC_HIDDEN__ void    _thread_arc4_unlock(void);
 
 extern volatile sig_atomic_t _rs_forked;
 
+/*
+ * Set by the first clone() that shares our address space (which includes
+ * every pthread_create()), and never cleared. Until then the process has
+ * exactly one thread, so stdio can skip its FILE locks.
+ */
+__LIBC_HIDDEN__ extern bool __libc_multi_threaded;
+
 __END_DECLS
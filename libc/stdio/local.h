@@ -38,6 +38,8 @@
 #include <stdbool.h>
 #include <wchar.h>
 
+#include "private/thread_private.h"
+
 #if defined(__cplusplus)  // Until we fork all of stdio...
 #include "private/bionic_fortify.h"
 #endif
@@ -134,12 +136,23 @@ struct __sfileext {
   // __fsetlocking support.
   bool _caller_handles_locking;
 
+  // Set by flockfile(3) and ftrylockfile(3), and never cleared. Once the
+  // caller has taken the lock themselves, stdio always locks this FILE too.
+  bool _explicitly_locked;
+
   // Equivalent to `_seek` but for _FILE_OFFSET_BITS=64.
   // Callers should use this but fall back to `__sFILE::_seek`.
   off64_t (*_seek64)(void*, off64_t, int);
 
   // The pid of the child if this FILE* is from popen(3).
   pid_t _popen_pid;
+
+  // The mapping of the whole file if this FILE* is from fopen(3) with 'm'.
+  // `_mmap_offset` is the offset of the next byte the `_read` function will
+  // hand out, which is what stdio treats as the underlying file position.
+  unsigned char* _mmap_base;
+  size_t _mmap_size;
+  off64_t _mmap_offset;
 };
 
 // Values for `__sFILE::_flags`.
@@ -208,6 +221,7 @@ int __swhatbuf(FILE*, size_t*, int*);
 wint_t __fgetwc_unlock(FILE*);
 wint_t __ungetwc(wint_t, FILE*);
 int __vfprintf(FILE*, const char*, va_list);
+int __vsnprintf_fast(char*, size_t, const char*, va_list);
 int __svfscanf(FILE*, const char*, va_list);
 int __vfwprintf(FILE*, const wchar_t*, va_list);
 int __vfwscanf(FILE*, const wchar_t*, va_list);
@@ -228,10 +242,23 @@ int __vfwscanf(FILE*, const wchar_t*, va_list);
     _UB(fp)._base = NULL;                                  \
   }
 
+/*
+ * FILE locks are elided until the process creates its second thread (or the
+ * caller locks the FILE with flockfile(3)), and always for streams whose
+ * caller asked for FSETLOCKING_BYCALLER.
+ *
+ * An elided FLOCKFILE can still be followed by a real FUNLOCKFILE if a read
+ * or write callback creates the first thread. Because flockfile(3) turns
+ * elision off for the FILE, that unlock can't release a hold the caller took
+ * explicitly; it only unlocks a mutex this thread doesn't own, which fails.
+ * Prefer ScopedFileLock in new code, which remembers what it did.
+ */
+#define __FILE_NEEDS_LOCK(fp) \
+  ((__libc_multi_threaded || _EXT(fp)->_explicitly_locked) && !_EXT(fp)->_caller_handles_locking)
 #define FLOCKFILE(fp) \
-  if (!_EXT(fp)->_caller_handles_locking) flockfile(fp)
+  if (__FILE_NEEDS_LOCK(fp)) flockfile(fp)
 #define FUNLOCKFILE(fp) \
-  if (!_EXT(fp)->_caller_handles_locking) funlockfile(fp)
+  if (__FILE_NEEDS_LOCK(fp)) funlockfile(fp)
 
 /* OpenBSD exposes these in <stdio.h>, but we only want them exposed to the implementation. */
 #define __sferror(p) (((p)->_flags & __SERR) != 0)
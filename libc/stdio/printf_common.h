@@ -118,6 +118,41 @@ static int __grow_type_table(unsigned char** typetable, int* tablesize);
 #define is_digit(c) ((unsigned)to_digit(c) <= 9)
 #define to_char(n) ((CHAR_TYPE)((n) + '0'))
 
+// "00" through "99", for converting two decimal digits at a time.
+static constexpr char __two_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of `value` so that they end just before `end`,
+// and returns a pointer to the first digit. Taking digits two at a time
+// from a table halves the number of divisions.
+template <typename CharT>
+static CharT* __ultoa_dec(uintmax_t value, CharT* end) {
+  CharT* p = end;
+  while (value >= 100) {
+    unsigned pair = static_cast<unsigned>(value % 100) * 2;
+    value /= 100;
+    *--p = __two_digits[pair + 1];
+    *--p = __two_digits[pair];
+  }
+  if (value >= 10) {
+    unsigned pair = static_cast<unsigned>(value) * 2;
+    *--p = __two_digits[pair + 1];
+    *--p = __two_digits[pair];
+  } else {
+    *--p = to_char(value);
+  }
+  return p;
+}
+
 template <typename CharT>
 static int exponent(CharT* p0, int exp, int fmtch) {
   CharT* p = p0;
@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/param.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
@@ -123,15 +124,18 @@ static struct glue* lastglue = &__sglue;
 
 class ScopedFileLock {
  public:
-  explicit ScopedFileLock(FILE* fp) : fp_(fp) {
-    FLOCKFILE(fp_);
+  // Remember whether we actually locked, so that a thread created while we
+  // hold an elided lock can't make us release someone else's hold.
+  explicit ScopedFileLock(FILE* fp) : fp_(fp), locked_(__FILE_NEEDS_LOCK(fp)) {
+    if (locked_) flockfile(fp_);
   }
   ~ScopedFileLock() {
-    FUNLOCKFILE(fp_);
+    if (locked_) funlockfile(fp_);
   }
 
  private:
   FILE* fp_;
+  bool locked_;
 };
 
 static glue* moreglue(int n) {
@@ -244,6 +248,82 @@ static FILE* __FILE_init(FILE* fp, int fd, int flags) {
   return fp;
 }
 
+// `_read` for FILEs from __FILE_mmap(). Normally the buffer *is* the mapping,
+// so the first refill just hands over the whole file without copying, and any
+// later refill is EOF. If setvbuf() gave the FILE a different buffer, or
+// fread() wants more than a buffer's worth, this copies out of the mapping
+// instead of calling read(2).
+static int __mmap_read(void* cookie, char* buf, int n) {
+  FILE* fp = reinterpret_cast<FILE*>(cookie);
+  __sfileext* ext = _EXT(fp);
+  if (n <= 0 || ext->_mmap_offset >= static_cast<off64_t>(ext->_mmap_size)) return 0;
+
+  unsigned char* src = ext->_mmap_base + ext->_mmap_offset;
+  size_t count = MIN(static_cast<size_t>(ext->_mmap_size - ext->_mmap_offset), static_cast<size_t>(n));
+  if (reinterpret_cast<unsigned char*>(buf) != src) memcpy(buf, src, count);
+  ext->_mmap_offset += count;
+  return count;
+}
+
+static off64_t __mmap_seek64(void* cookie, off64_t offset, int whence) {
+  FILE* fp = reinterpret_cast<FILE*>(cookie);
+  __sfileext* ext = _EXT(fp);
+  if (whence == SEEK_CUR) {
+    offset += ext->_mmap_offset;
+  } else if (whence == SEEK_END) {
+    offset += ext->_mmap_size;
+  } else if (whence != SEEK_SET) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  ext->_mmap_offset = offset;
+  return offset;
+}
+
+// Implements fopen()'s 'm' mode: map a regular file and use the mapping as
+// the FILE's buffer, so reads are served without read(2) or an extra copy.
+// Anything that can't be mapped (pipes, sockets, empty files, files too big
+// for `_r`) silently keeps normal buffering.
+static void __FILE_mmap(FILE* fp) {
+  ErrnoRestorer errno_restorer;
+
+  struct stat sb;
+  if (fstat(fp->_file, &sb) == -1 || !S_ISREG(sb.st_mode)) return;
+  if (sb.st_size <= 0 || sb.st_size > INT_MAX) return;
+
+  // The mapping is writable (but private) because fgetln() returns pointers
+  // into the buffer that callers are allowed to modify.
+  void* map = mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fp->_file, 0);
+  if (map == MAP_FAILED) return;
+
+  __sfileext* ext = _EXT(fp);
+  ext->_mmap_base = static_cast<unsigned char*>(map);
+  ext->_mmap_size = sb.st_size;
+  ext->_mmap_offset = 0;
+  fp->_bf._base = fp->_p = ext->_mmap_base;
+  fp->_bf._size = sb.st_size;
+  fp->_r = 0;
+  fp->_read = __mmap_read;
+  ext->_seek64 = __mmap_seek64;
+}
+
+static void __FILE_munmap(FILE* fp) {
+  __sfileext* ext = _EXT(fp);
+  if (ext->_mmap_base == nullptr) return;
+  if (fp->_bf._base == ext->_mmap_base) {
+    fp->_bf._base = fp->_p = nullptr;
+    fp->_bf._size = 0;
+  }
+  munmap(ext->_mmap_base, ext->_mmap_size);
+  ext->_mmap_base = nullptr;
+  ext->_mmap_size = 0;
+  ext->_mmap_offset = 0;
+}
+
 FILE* fopen(const char* file, const char* mode) {
   int mode_flags;
   int flags = __sflags(mode, &mode_flags);
@@ -264,6 +344,9 @@ FILE* fopen(const char* file, const char* mode) {
   // For append mode, O_APPEND sets the write position for free, but we need to
   // set the read position manually.
   if ((mode_flags & O_APPEND) != 0) __sseek64(fp, 0, SEEK_END);
+
+  // The 'm' mode is only honored for read-only streams.
+  if (flags == __SRD && strchr(mode, 'm') != nullptr) __FILE_mmap(fp);
   return fp;
 }
 __strong_alias(fopen64, fopen);
@@ -365,6 +448,7 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   // of any setbuffer calls, but stdio has always done this before.
   if (isopen && fd != wantfd) (*fp->_close)(fp->_cookie);
   if (fp->_flags & __SMBF) free(fp->_bf._base);
+  __FILE_munmap(fp);
   fp->_w = 0;
   fp->_r = 0;
   fp->_p = nullptr;
@@ -417,6 +501,7 @@ static int __FILE_close(FILE* fp) {
     r = EOF;
   }
   if (fp->_flags & __SMBF) free(fp->_bf._base);
+  __FILE_munmap(fp);
   if (HASUB(fp)) FREEUB(fp);
   free_fgetln_buffer(fp);
 
@@ -623,6 +708,14 @@ int __fseeko64(FILE* fp, off64_t offset, int whence, int off_t_bits) {
   if (HASUB(fp)) FREEUB(fp);
   fp->_p = fp->_bf._base;
   fp->_r = 0;
+  __sfileext* ext = _EXT(fp);
+  if (ext->_mmap_base != nullptr && fp->_bf._base == ext->_mmap_base &&
+      ext->_mmap_offset < static_cast<off64_t>(ext->_mmap_size)) {
+    // The whole file is already in the buffer, so just point at the new position.
+    fp->_p = ext->_mmap_base + ext->_mmap_offset;
+    fp->_r = ext->_mmap_size - ext->_mmap_offset;
+    ext->_mmap_offset = ext->_mmap_size;
+  }
   /* fp->_w = 0; */	/* unnecessary (I think...) */
   fp->_flags &= ~__SEOF;
   return 0;
@@ -868,11 +961,148 @@ int getchar() {
   return getc(stdin);
 }
 
+// The smallest buffer getdelim() and fgetln() will allocate. This should let
+// typical config file lines fit without ever needing to grow the buffer.
+static constexpr size_t kMinLineBufferSize = 128;
+
+// Returns the size to grow a line buffer of `size` bytes to so that it can
+// hold at least `needed` bytes. Growth is geometric so that reading a long
+// line costs amortized O(1) per byte rather than one realloc() per refill.
+static size_t __line_buffer_size(size_t size, size_t needed) {
+  if (size < kMinLineBufferSize) size = kMinLineBufferSize;
+  while (size < needed) {
+    if (__builtin_mul_overflow(size, 2, &size)) return needed;
+  }
+  return size;
+}
+
+ssize_t getdelim(char** buf, size_t* buf_size, int delimiter, FILE* fp) {
+  CHECK_FP(fp);
+  ScopedFileLock sfl(fp);
+
+  if (buf == nullptr || buf_size == nullptr) {
+    fp->_flags |= __SERR;
+    errno = EINVAL;
+    return -1;
+  }
+
+  // If the caller didn't give us a buffer, assume it has no space.
+  if (*buf == nullptr) *buf_size = 0;
+
+  _SET_ORIENTATION(fp, ORIENT_BYTES);
+
+  size_t length = 0;
+  while (true) {
+    // If the FILE's buffer is empty, refill it.
+    if (fp->_r <= 0 && __srefill(fp)) {
+      if (__sferror(fp)) return -1;
+      // EOF: return whatever we have so far.
+      break;
+    }
+
+    // Scan the whole of the FILE's buffer with the optimized memchr(),
+    // and copy up to and including the delimiter in one go.
+    unsigned char* p = fp->_p;
+    unsigned char* end = static_cast<unsigned char*>(memchr(p, delimiter, fp->_r));
+    size_t chunk = (end != nullptr) ? (end + 1 - p) : fp->_r;
+
+    // Make sure the result (plus a NUL) still fits in an ssize_t.
+    if (length > SSIZE_MAX || chunk + 1 > SSIZE_MAX - length) {
+      fp->_flags |= __SERR;
+      errno = EOVERFLOW;
+      return -1;
+    }
+    size_t needed = length + chunk + 1;
+    if (needed > *buf_size) {
+      size_t new_size = __line_buffer_size(*buf_size, needed);
+      char* new_buf = static_cast<char*>(realloc(*buf, new_size));
+      if (new_buf == nullptr) {
+        fp->_flags |= __SERR;
+        return -1;
+      }
+      *buf = new_buf;
+      *buf_size = new_size;
+    }
+
+    memcpy(*buf + length, p, chunk);
+    fp->_r -= chunk;
+    fp->_p += chunk;
+    length += chunk;
+    if (end != nullptr) break;
+  }
+
+  // POSIX demands we return -1 on EOF.
+  if (length == 0) return -1;
+
+  (*buf)[length] = '\0';
+  return length;
+}
+
 ssize_t getline(char** buf, size_t* len, FILE* fp) {
   CHECK_FP(fp);
   return getdelim(buf, len, '\n', fp);
 }
 
+// Returns a pointer to the next line, which is not NUL-terminated. When the
+// whole line is already in the FILE's buffer, that's a pointer straight into
+// it and nothing is copied; otherwise the line is assembled in `_lb`.
+// Either way, the result is only valid until the next operation on `fp`.
+char* fgetln(FILE* fp, size_t* length_ptr) {
+  CHECK_FP(fp);
+  ScopedFileLock sfl(fp);
+
+  _SET_ORIENTATION(fp, ORIENT_BYTES);
+
+  // Make sure there's input.
+  if (fp->_r <= 0 && __srefill(fp)) {
+    *length_ptr = 0;
+    return nullptr;
+  }
+
+  unsigned char* p = fp->_p;
+  unsigned char* end = static_cast<unsigned char*>(memchr(p, '\n', fp->_r));
+  if (end != nullptr) {
+    size_t length = end + 1 - p;
+    fp->_r -= length;
+    fp->_p += length;
+    *length_ptr = length;
+    return reinterpret_cast<char*>(p);
+  }
+
+  // The line straddles a refill, so we have to copy it to the line buffer.
+  size_t length = 0;
+  while (true) {
+    p = fp->_p;
+    size_t chunk = (end != nullptr) ? (end + 1 - p) : fp->_r;
+    size_t needed = length + chunk;
+    if (needed > static_cast<size_t>(fp->_lb._size)) {
+      size_t new_size = __line_buffer_size(fp->_lb._size, needed);
+      void* new_buf = realloc(fp->_lb._base, new_size);
+      if (new_buf == nullptr) {
+        *length_ptr = 0;
+        return nullptr;
+      }
+      fp->_lb._base = static_cast<unsigned char*>(new_buf);
+      fp->_lb._size = new_size;
+    }
+    memcpy(fp->_lb._base + length, p, chunk);
+    fp->_r -= chunk;
+    fp->_p += chunk;
+    length += chunk;
+    if (end != nullptr) break;
+
+    if (__srefill(fp)) {
+      // EOF: return the final, unterminated, line.
+      if (fp->_flags & __SEOF) break;
+      *length_ptr = 0;
+      return nullptr;
+    }
+    end = static_cast<unsigned char*>(memchr(fp->_p, '\n', fp->_r));
+  }
+  *length_ptr = length;
+  return reinterpret_cast<char*>(fp->_lb._base);
+}
+
 wint_t getwc(FILE* fp) {
   CHECK_FP(fp);
   return fgetwc(fp);
@@ -1027,6 +1257,14 @@ int vsnprintf(char* s, size_t n, const char* fmt, va_list ap) {
     n = 1;
   }
 
+  // Most snprintf() calls only use simple conversions, which we can format
+  // straight into `s` without setting up a fake FILE.
+  va_list fast_ap;
+  va_copy(fast_ap, ap);
+  int result = __vsnprintf_fast(s, n, fmt, fast_ap);
+  va_end(fast_ap);
+  if (result >= 0) return result;
+
   FILE f;
   __sfileext fext;
   _FILEEXT_SETUP(&f, &fext);
@@ -1035,7 +1273,7 @@ int vsnprintf(char* s, size_t n, const char* fmt, va_list ap) {
   f._bf._base = f._p = reinterpret_cast<unsigned char*>(s);
   f._bf._size = f._w = n - 1;
 
-  int result = __vfprintf(&f, fmt, ap);
+  result = __vfprintf(&f, fmt, ap);
   *f._p = '\0';
   return result;
 }
@@ -1241,11 +1479,13 @@ int pclose(FILE* fp) {
 
 void flockfile(FILE* fp) {
   CHECK_FP(fp);
+  if (!_EXT(fp)->_explicitly_locked) _EXT(fp)->_explicitly_locked = true;
   pthread_mutex_lock(&_EXT(fp)->_lock);
 }
 
 int ftrylockfile(FILE* fp) {
   CHECK_FP(fp);
+  if (!_EXT(fp)->_explicitly_locked) _EXT(fp)->_explicitly_locked = true;
   // The specification for ftrylockfile() says it returns 0 on success,
   // or non-zero on error. We don't bother canonicalizing to 0/-1...
   return pthread_mutex_trylock(&_EXT(fp)->_lock);
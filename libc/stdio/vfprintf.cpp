@@ -606,12 +606,7 @@ signed_decimal:
               break;
 
             case DEC:
-              /* many numbers are 1 digit */
-              while (_umax >= 10) {
-                *--cp = to_char(_umax % 10);
-                _umax /= 10;
-              }
-              *--cp = to_char(_umax);
+              cp = __ultoa_dec(_umax, cp);
               break;
 
             case HEX:
@@ -734,3 +729,133 @@ finish:
   }
   return (ret);
 }
+
+// Returns true if every conversion in `fmt` is a plain %d, %i, %u, %x, %X, %s,
+// %c or %% (optionally with an l, ll, j, t or z length modifier) with no
+// flags, width, precision, or positional arguments.
+static bool __is_simple_format(const char* fmt) {
+  while ((fmt = strchr(fmt, '%')) != nullptr) {
+    ++fmt;
+    if (*fmt == 'l') {
+      fmt += (fmt[1] == 'l') ? 2 : 1;
+    } else if (*fmt == 'j' || *fmt == 't' || *fmt == 'z') {
+      ++fmt;
+    }
+    switch (*fmt++) {
+      case 'd': case 'i': case 'u': case 'x': case 'X':
+        break;
+      case 's': case 'c': case '%':
+        // Only valid without a length modifier (%ls and %lc need conversion).
+        if (fmt[-2] != '%') return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// A fast path for vsnprintf() that formats straight into the caller's buffer
+// without going through the generic conversion loop and uio machinery. Only
+// formats accepted by __is_simple_format() are handled; for anything else (or
+// if the result would overflow an int) this returns -1 without consuming any
+// meaningful state, and the caller should fall back to __vfprintf() with a
+// fresh copy of the va_list. `n` must be at least 1.
+int __vsnprintf_fast(char* s, size_t n, const char* fmt, va_list ap) {
+  if (!__is_simple_format(fmt)) return -1;
+
+  // vsprintf() passes SSIZE_MAX for `n`, so don't compute `s + n`.
+  char* p = s;
+  size_t room = n - 1;
+  size_t total = 0;
+  auto append = [&](const char* src, size_t length) {
+    size_t count = MIN(length, room);
+    memcpy(p, src, count);
+    p += count;
+    room -= count;
+    total += length;
+  };
+
+  char buf[BUF];
+  while (true) {
+    const char* percent = strchr(fmt, '%');
+    if (percent == nullptr) percent = fmt + strlen(fmt);
+    append(fmt, percent - fmt);
+    if (*percent == '\0') break;
+    fmt = percent + 1;
+
+    int length = 0;
+    if (*fmt == 'l') {
+      length = (fmt[1] == 'l') ? LLONGINT : LONGINT;
+      fmt += (length == LLONGINT) ? 2 : 1;
+    } else if (*fmt == 'j') {
+      length = MAXINT;
+      ++fmt;
+    } else if (*fmt == 't') {
+      length = PTRINT;
+      ++fmt;
+    } else if (*fmt == 'z') {
+      length = SIZEINT;
+      ++fmt;
+    }
+
+    char ch = *fmt++;
+    if (ch == 's') {
+      const char* str = va_arg(ap, const char*);
+      if (str == nullptr) str = "(null)";
+      append(str, strlen(str));
+      continue;
+    } else if (ch == 'c') {
+      char c = static_cast<char>(va_arg(ap, int));
+      append(&c, 1);
+      continue;
+    } else if (ch == '%') {
+      append("%", 1);
+      continue;
+    }
+
+    uintmax_t value;
+    bool negative = false;
+    if (ch == 'd' || ch == 'i') {
+      intmax_t signed_value;
+      switch (length) {
+        case LONGINT: signed_value = va_arg(ap, long); break;
+        case LLONGINT: signed_value = va_arg(ap, long long); break;
+        case MAXINT: signed_value = va_arg(ap, intmax_t); break;
+        case PTRINT: signed_value = va_arg(ap, ptrdiff_t); break;
+        case SIZEINT: signed_value = va_arg(ap, ssize_t); break;
+        default: signed_value = va_arg(ap, int); break;
+      }
+      negative = (signed_value < 0);
+      value = negative ? -static_cast<uintmax_t>(signed_value) : signed_value;
+    } else {
+      switch (length) {
+        case LONGINT: value = va_arg(ap, unsigned long); break;
+        case LLONGINT: value = va_arg(ap, unsigned long long); break;
+        case MAXINT: value = va_arg(ap, uintmax_t); break;
+        case PTRINT: value = va_arg(ap, ptrdiff_t); break;
+        case SIZEINT: value = va_arg(ap, size_t); break;
+        default: value = va_arg(ap, unsigned int); break;
+      }
+    }
+
+    char* end = buf + BUF;
+    char* digits;
+    if (ch == 'x' || ch == 'X') {
+      const char* xdigs = (ch == 'x') ? "0123456789abcdef" : "0123456789ABCDEF";
+      digits = end;
+      do {
+        *--digits = xdigs[value & 15];
+        value >>= 4;
+      } while (value);
+    } else {
+      digits = __ultoa_dec(value, end);
+      if (negative) *--digits = '-';
+    }
+    append(digits, end - digits);
+  }
+
+  if (total > INT_MAX) return -1;
+  *p = '\0';
+  return total;
+}
@@ -584,12 +584,7 @@ signed_decimal:
               break;
 
             case DEC:
-              /* many numbers are 1 digit */
-              while (_umax >= 10) {
-                *--cp = to_char(_umax % 10);
-                _umax /= 10;
-              }
-              *--cp = to_char(_umax);
+              cp = __ultoa_dec(_umax, cp);
               break;
 
             case HEX:
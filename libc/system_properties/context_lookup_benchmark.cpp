@@ -32,6 +32,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <memory>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -42,6 +44,7 @@
 #include <property_info_parser/property_info_parser.h>
 #include <property_info_serializer/property_info_serializer.h>
 #include <system_properties/contexts_split.h>
+#include <system_properties/prop_info_cache.h>
 
 #include "context_lookup_benchmark_data.h"
 
@@ -143,3 +146,47 @@ static void TrieLookupS(benchmark::State& state) {
   }
 }
 BENCHMARK(TrieLookupS);
+
+// A process that polls the same handful of properties over and over, which is
+// what the PropInfoCache in SystemProperties::Find is for.
+static std::vector<std::string> PolledProperties() {
+  auto properties = PropertiesToLookup();
+  properties.resize(32);
+  return properties;
+}
+
+static void TriePolledLookupS(benchmark::State& state) {
+  std::string serialized_trie = CreateSerializedTrie(aosp_s_property_contexts);
+  PropertyInfoArea* trie = reinterpret_cast<PropertyInfoArea*>(serialized_trie.data());
+  auto properties = PolledProperties();
+  for (auto _ : state) {
+    for (const auto& property : properties) {
+      trie->GetPropertyInfo(property.c_str(), nullptr, nullptr);
+    }
+  }
+}
+BENCHMARK(TriePolledLookupS);
+
+static void CachedPolledLookupS(benchmark::State& state) {
+  auto properties = PolledProperties();
+  std::vector<std::unique_ptr<char[]>> storage;
+  PropInfoCache cache{};
+  for (const auto& property : properties) {
+    storage.emplace_back(new char[sizeof(prop_info) + property.size() + 1]);
+    auto* pi = new (storage.back().get()) prop_info(property.c_str(), property.size(), "", 0);
+    uint32_t generation = cache.Generation();
+    uint32_t hash;
+    ContextNode* node;
+    cache.Find(property.c_str(), &hash, &node);
+    cache.Insert(hash, pi, nullptr, generation);
+  }
+  for (auto _ : state) {
+    for (const auto& property : properties) {
+      benchmark::DoNotOptimize(cache.Generation());
+      uint32_t hash;
+      ContextNode* node;
+      benchmark::DoNotOptimize(cache.Find(property.c_str(), &hash, &node));
+    }
+  }
+}
+BENCHMARK(CachedPolledLookupS);
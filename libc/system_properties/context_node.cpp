@@ -55,6 +55,7 @@ bool ContextNode::Open(bool access_rw, bool* fsetxattr_failed) {
   } else {
     pa_ = prop_area::map_prop_area(filename.c_str());
   }
+  if (pa_) atomic_fetch_add_explicit(&map_count_, 1, memory_order_relaxed);
   lock_.unlock();
   return pa_;
 }
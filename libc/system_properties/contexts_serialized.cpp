@@ -130,7 +130,7 @@ bool ContextsSerialized::Initialize(bool writable, const char* dirname, bool* fs
   return true;
 }
 
-prop_area* ContextsSerialized::GetPropAreaForName(const char* name) {
+prop_area* ContextsSerialized::GetPropAreaForName(const char* name, ContextNode** node) {
   uint32_t index;
   property_info_area_file_->GetPropertyInfoIndexes(name, &index, nullptr);
   if (index == ~0u || index >= num_context_nodes_) {
@@ -139,6 +139,8 @@ prop_area* ContextsSerialized::GetPropAreaForName(const char* name) {
     return nullptr;
   }
   auto* context_node = &context_nodes_[index];
+  context_node->RecordLookup();
+  if (node != nullptr) *node = context_node;
   if (!context_node->pa()) {
     // We explicitly do not check no_access_ in this case because unlike the
     // case of foreach(), we want to generate an selinux audit for each
@@ -156,6 +158,13 @@ void ContextsSerialized::ForEach(void (*propfn)(const prop_info* pi, void* cooki
   }
 }
 
+void ContextsSerialized::ForEachContext(void (*fn)(const ContextNode* node, void* cookie),
+                                        void* cookie) {
+  for (size_t i = 0; i < num_context_nodes_; ++i) {
+    fn(&context_nodes_[i], cookie);
+  }
+}
+
 void ContextsSerialized::ResetAccess() {
   for (size_t i = 0; i < num_context_nodes_; ++i) {
     context_nodes_[i].ResetAccess();
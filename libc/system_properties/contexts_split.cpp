@@ -320,13 +320,15 @@ PrefixNode* ContextsSplit::GetPrefixNodeForName(const char* name) {
   return entry;
 }
 
-prop_area* ContextsSplit::GetPropAreaForName(const char* name) {
+prop_area* ContextsSplit::GetPropAreaForName(const char* name, ContextNode** node) {
   auto entry = GetPrefixNodeForName(name);
   if (!entry) {
     return nullptr;
   }
 
   auto cnode = entry->context;
+  cnode->RecordLookup();
+  if (node != nullptr) *node = cnode;
   if (!cnode->pa()) {
     // We explicitly do not check no_access_ in this case because unlike the
     // case of foreach(), we want to generate an selinux audit for each
@@ -344,6 +346,11 @@ void ContextsSplit::ForEach(void (*propfn)(const prop_info* pi, void* cookie), v
   });
 }
 
+void ContextsSplit::ForEachContext(void (*fn)(const ContextNode* node, void* cookie),
+                                   void* cookie) {
+  ListForEach(contexts_, [fn, cookie](ContextListNode* l) { fn(l, cookie); });
+}
+
 void ContextsSplit::ResetAccess() {
   ListForEach(contexts_, [](ContextListNode* l) { l->ResetAccess(); });
 }
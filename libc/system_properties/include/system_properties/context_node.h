@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <stdatomic.h>
+#include <stdint.h>
+
 #include "private/bionic_lock.h"
 
 #include "prop_area.h"
@@ -37,6 +40,8 @@ class ContextNode {
   ContextNode(const char* context, const char* filename)
       : context_(context), pa_(nullptr), no_access_(false), filename_(filename) {
     lock_.init(false);
+    atomic_init(&map_count_, 0u);
+    atomic_init(&lookup_count_, 0u);
   }
   ~ContextNode() {
     Unmap();
@@ -55,6 +60,27 @@ class ContextNode {
   prop_area* pa() {
     return pa_;
   }
+  const prop_area* pa() const {
+    return pa_;
+  }
+
+  // Whether `pi` lives in this context's currently mapped prop_area.
+  bool Contains(const prop_info* pi) const {
+    uintptr_t base = reinterpret_cast<uintptr_t>(pa_);
+    uintptr_t p = reinterpret_cast<uintptr_t>(pi);
+    return pa_ != nullptr && p >= base && p - base < prop_area::pa_size();
+  }
+
+  // Statistics for __system_properties_foreach_context.
+  void RecordLookup() {
+    atomic_fetch_add_explicit(&lookup_count_, 1, memory_order_relaxed);
+  }
+  uint32_t lookup_count() const {
+    return atomic_load_explicit(&lookup_count_, memory_order_relaxed);
+  }
+  uint32_t map_count() const {
+    return atomic_load_explicit(&map_count_, memory_order_relaxed);
+  }
 
  private:
   bool CheckAccess();
@@ -64,4 +90,6 @@ class ContextNode {
   prop_area* pa_;
   bool no_access_;
   const char* filename_;
+  atomic_uint_least32_t map_count_;
+  atomic_uint_least32_t lookup_count_;
 };
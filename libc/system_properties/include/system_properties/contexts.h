@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include "context_node.h"
 #include "prop_area.h"
 #include "prop_info.h"
 
@@ -38,9 +39,12 @@ class Contexts {
 
   virtual bool Initialize(bool writable, const char* filename, bool* fsetxattr_failed,
                           bool load_default_path = false) = 0;
-  virtual prop_area* GetPropAreaForName(const char* name) = 0;
+  // If `node` is non-null, it's set to the context the name belongs to, or to
+  // nullptr if there are no separate contexts.
+  virtual prop_area* GetPropAreaForName(const char* name, ContextNode** node = nullptr) = 0;
   virtual prop_area* GetSerialPropArea() = 0;
   virtual void ForEach(void (*propfn)(const prop_info* pi, void* cookie), void* cookie) = 0;
+  virtual void ForEachContext(void (*fn)(const ContextNode* node, void* cookie), void* cookie) = 0;
   virtual void ResetAccess() = 0;
   virtual void FreeAndUnmap() = 0;
 };
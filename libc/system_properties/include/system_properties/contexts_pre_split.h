@@ -43,7 +43,8 @@ class ContextsPreSplit : public Contexts {
     return pre_split_prop_area_ != nullptr;
   }
 
-  virtual prop_area* GetPropAreaForName(const char*) override {
+  virtual prop_area* GetPropAreaForName(const char*, ContextNode** node) override {
+    if (node != nullptr) *node = nullptr;
     return pre_split_prop_area_;
   }
 
@@ -55,6 +56,10 @@ class ContextsPreSplit : public Contexts {
     pre_split_prop_area_->foreach (propfn, cookie);
   }
 
+  // There are no contexts, just the one property file.
+  virtual void ForEachContext(void (*)(const ContextNode*, void*), void*) override {
+  }
+
   // This is a no-op for pre-split properties as there is only one property file and it is
   // accessible by all domains
   virtual void ResetAccess() override {
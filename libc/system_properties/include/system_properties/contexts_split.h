@@ -40,11 +40,13 @@ class ContextsSplit : public Contexts {
 
   virtual bool Initialize(bool writable, const char* filename, bool* fsetxattr_failed,
                           bool) override;
-  virtual prop_area* GetPropAreaForName(const char* name) override;
+  virtual prop_area* GetPropAreaForName(const char* name, ContextNode** node) override;
   virtual prop_area* GetSerialPropArea() override {
     return serial_prop_area_;
   }
   virtual void ForEach(void (*propfn)(const prop_info* pi, void* cookie), void* cookie) override;
+  virtual void ForEachContext(void (*fn)(const ContextNode* node, void* cookie),
+                              void* cookie) override;
   virtual void ResetAccess() override;
   virtual void FreeAndUnmap() override;
 
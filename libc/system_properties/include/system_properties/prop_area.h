@@ -94,6 +94,13 @@ class prop_area {
   static prop_area* map_prop_area_rw(const char* filename, const char* context,
                                      bool* fsetxattr_failed);
   static prop_area* map_prop_area(const char* filename);
+  // Every area is mapped with the same size.
+  static size_t pa_size() {
+    return pa_size_;
+  }
+  static size_t pa_data_size() {
+    return pa_data_size_;
+  }
   static void unmap_prop_area(prop_area** pa) {
     if (*pa) {
       munmap(*pa, pa_size_);
@@ -136,6 +143,11 @@ class prop_area {
   uint32_t version() const {
     return version_;
   }
+  // Space is never freed, so this only grows. Only the property service
+  // writes it, so other processes may see a slightly stale value.
+  uint32_t bytes_used() const {
+    return bytes_used_;
+  }
   char* dirty_backup_area() { return data_ + sizeof(prop_trie_node); }
 
  private:
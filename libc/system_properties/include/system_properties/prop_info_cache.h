@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "prop_info.h"
+
+class ContextNode;
+
+// A small, lock-free, direct-mapped cache from property name to prop_info, so
+// that processes polling the same properties over and over don't have to walk
+// both the property_info trie and the prop_area trie every time.
+//
+// Only successful lookups are cached: a prop_info never moves or goes away
+// while its prop_area is mapped, but a property that doesn't exist yet might
+// be added at any time. The owner must Clear() the cache before unmapping or
+// remapping any prop_area.
+//
+// A lookup can race with Clear(), and mustn't then put a prop_info from the
+// old areas back. So callers take the Generation() before they look a name
+// up, and pass it to Insert(), which drops the entry if a Clear() has
+// happened since.
+//
+// Each entry also remembers the context its prop_info was found in, so that
+// cache hits can be counted against that context like any other lookup.
+//
+// There's deliberately no constructor: SystemProperties lives in .bss and must
+// not have any initialization run on it (see system_properties.h).
+class PropInfoCache {
+ public:
+  // Returns the cached prop_info for `name`, or nullptr. Either way, `*hash` is
+  // set so that a miss can be followed by Insert() without rehashing. On a hit,
+  // `*node` is set to the context that was passed to Insert(), but a racing
+  // Insert() into the same slot may have replaced it, so callers that care
+  // must check that the prop_info really is in that context.
+  const prop_info* Find(const char* name, uint32_t* hash, ContextNode** node) const {
+    // FNV-1a.
+    uint32_t h = 2166136261u;
+    for (const char* p = name; *p != '\0'; ++p) {
+      h = (h ^ static_cast<uint8_t>(*p)) * 16777619u;
+    }
+    *hash = h;
+
+    // Another thread may replace this entry at any time, so we have to check
+    // that we got the property we asked for rather than trusting the hash.
+    const prop_info* pi = __atomic_load_n(&entries_[h % kSize], __ATOMIC_ACQUIRE);
+    if (pi != nullptr && strcmp(pi->name, name) == 0) {
+      *node = __atomic_load_n(&nodes_[h % kSize], __ATOMIC_RELAXED);
+      return pi;
+    }
+    return nullptr;
+  }
+
+  uint32_t Generation() const { return __atomic_load_n(&generation_, __ATOMIC_SEQ_CST); }
+
+  void Insert(uint32_t hash, const prop_info* pi, ContextNode* node, uint32_t generation) {
+    const prop_info** entry = &entries_[hash % kSize];
+    if (Generation() != generation) return;
+    // Published by the store to the entry below.
+    __atomic_store_n(&nodes_[hash % kSize], node, __ATOMIC_RELAXED);
+    __atomic_store_n(entry, pi, __ATOMIC_SEQ_CST);
+    // A Clear() may have bumped the generation after the check above but
+    // emptied this entry before our store landed. Clear() bumps the
+    // generation before it empties anything, so in that case we'll see the
+    // new generation here, and take our entry back out.
+    if (Generation() != generation) {
+      __atomic_compare_exchange_n(entry, &pi, nullptr, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    }
+  }
+
+  void Clear() {
+    __atomic_fetch_add(&generation_, 1, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < kSize; ++i) {
+      __atomic_store_n(&entries_[i], nullptr, __ATOMIC_RELAXED);
+    }
+  }
+
+ private:
+  static constexpr size_t kSize = 128;
+  const prop_info* entries_[kSize];
+  ContextNode* nodes_[kSize];
+  uint32_t generation_;
+};
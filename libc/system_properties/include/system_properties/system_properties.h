@@ -35,6 +35,9 @@
 #include "contexts_pre_split.h"
 #include "contexts_serialized.h"
 #include "contexts_split.h"
+#include "prop_info_cache.h"
+
+struct prop_context_stats;
 
 class SystemProperties {
  public:
@@ -46,7 +49,7 @@ class SystemProperties {
   // We rely on the static SystemProperties in libc to be placed in .bss and zero initialized.
   SystemProperties() = default;
   // Special constructor for testing that also zero initializes the important members.
-  explicit SystemProperties(bool initialized) : initialized_(initialized) {
+  explicit SystemProperties(bool initialized) : initialized_(initialized), find_cache_() {
   }
 
   BIONIC_DISALLOW_COPY_AND_ASSIGN(SystemProperties);
@@ -68,8 +71,13 @@ class SystemProperties {
   uint32_t WaitAny(uint32_t old_serial);
   bool Wait(const prop_info* pi, uint32_t old_serial, uint32_t* new_serial_ptr,
             const timespec* relative_timeout);
+  int ReadBatch(const prop_info* const* pis, size_t count, char (*values)[PROP_VALUE_MAX],
+                uint32_t* serials);
+  bool WaitMultiple(const prop_info* const* pis, const uint32_t* old_serials, size_t count,
+                    uint32_t* new_serials, const timespec* relative_timeout);
   const prop_info* FindNth(unsigned n);
   int Foreach(void (*propfn)(const prop_info* pi, void* cookie), void* cookie);
+  int ForeachContext(void (*callback)(const prop_context_stats* stats, void* cookie), void* cookie);
 
  private:
   uint32_t ReadMutablePropertyValue(const prop_info* pi, char* value);
@@ -92,4 +100,7 @@ class SystemProperties {
   bool initialized_;
   PropertiesFilename properties_filename_;
   PropertiesFilename appcompat_filename_;
+
+  // Recently found properties. Cleared whenever contexts_ might unmap an area.
+  PropInfoCache find_cache_;
 };
@@ -167,6 +167,12 @@ prop_trie_node* prop_area::new_prop_trie_node(const char* name, uint32_t namelen
 
 prop_info* prop_area::new_prop_info(const char* name, uint32_t namelen, const char* value,
                                     uint32_t valuelen, uint_least32_t* const off) {
+  // Check there's room for everything first, so that a long value that doesn't
+  // fit doesn't leave behind a prop_info nothing points to.
+  size_t needed = __BIONIC_ALIGN(sizeof(prop_info) + namelen + 1, sizeof(uint_least32_t));
+  if (valuelen >= PROP_VALUE_MAX) needed += __BIONIC_ALIGN(valuelen + 1, sizeof(uint_least32_t));
+  if (bytes_used_ + needed > pa_data_size_) return nullptr;
+
   uint_least32_t new_offset;
   void* const p = allocate_obj(sizeof(prop_info) + namelen + 1, &new_offset);
   if (p == nullptr) return nullptr;
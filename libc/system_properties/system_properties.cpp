@@ -37,6 +37,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
+
 #include <new>
 
 #include <async_safe/CHECK.h>
@@ -44,6 +47,7 @@
 
 #include "private/ErrnoRestorer.h"
 #include "private/bionic_futex.h"
+#include "private/bionic_time_conversions.h"
 
 #include "system_properties/context_node.h"
 #include "system_properties/prop_area.h"
@@ -66,6 +70,8 @@ bool SystemProperties::Init(const char* filename) {
   ErrnoRestorer errno_restorer;
 
   if (initialized_) {
+    // ResetAccess() may unmap areas we no longer have access to.
+    find_cache_.Clear();
     contexts_->ResetAccess();
     return true;
   }
@@ -112,6 +118,7 @@ bool SystemProperties::AreaInit(const char* filename, bool* fsetxattr_failed) {
 // one file (specified by PropertyInfoAreaFile.LoadDefaultPath), but be written to "filename".
 bool SystemProperties::AreaInit(const char* filename, bool* fsetxattr_failed,
                                 bool load_default_path) {
+  find_cache_.Clear();
   properties_filename_ = filename;
   auto serial_contexts = new (contexts_data_) ContextsSerialized();
   contexts_ = serial_contexts;
@@ -138,6 +145,7 @@ bool SystemProperties::Reload(bool load_default_path) {
     return true;
   }
 
+  find_cache_.Clear();
   return InitContexts(load_default_path);
 }
 
@@ -160,13 +168,29 @@ const prop_info* SystemProperties::Find(const char* name) {
     return nullptr;
   }
 
-  prop_area* pa = contexts_->GetPropAreaForName(name);
+  uint32_t generation = find_cache_.Generation();
+  uint32_t hash;
+  ContextNode* node;
+  const prop_info* pi = find_cache_.Find(name, &hash, &node);
+  // Count a hit against its context just as a full lookup would be, unless
+  // there are no separate contexts. If another thread replaced the entry's
+  // context as we read it, just do the full lookup.
+  if (pi != nullptr && (node == nullptr || node->Contains(pi))) {
+    if (node != nullptr) node->RecordLookup();
+    return pi;
+  }
+
+  prop_area* pa = contexts_->GetPropAreaForName(name, &node);
   if (!pa) {
     async_safe_format_log(ANDROID_LOG_WARN, "libc", "Access denied finding property \"%s\"", name);
     return nullptr;
   }
 
-  return pa->find(name);
+  pi = pa->find(name);
+  if (pi != nullptr) {
+    find_cache_.Insert(hash, pi, node, generation);
+  }
+  return pi;
 }
 
 static bool is_appcompat_override(const char* name) {
@@ -358,6 +382,9 @@ int SystemProperties::Add(const char* name, unsigned int namelen, const char* va
 
   bool ret = pa->add(name, namelen, value, valuelen);
   if (!ret) {
+    async_safe_format_log(ANDROID_LOG_ERROR, "libc",
+                          "Could not add property \"%s\" (%u of %zu bytes of its area used)", name,
+                          pa->bytes_used(), prop_area::pa_data_size());
     return -1;
   }
 
@@ -436,6 +463,116 @@ bool SystemProperties::Wait(const prop_info* pi, uint32_t old_serial, uint32_t*
   return true;
 }
 
+int SystemProperties::ReadBatch(const prop_info* const* pis, size_t count,
+                                char (*values)[PROP_VALUE_MAX], uint32_t* serials) {
+  if (!initialized_) {
+    return -1;
+  }
+
+  prop_area* serial_pa = contexts_->GetSerialPropArea();
+  if (serial_pa == nullptr) {
+    return -1;
+  }
+
+  // Every Add and Update bumps the global serial once it's finished, so if the
+  // global serial is the same before and after reading every property, no update
+  // completed in between and the values we read are a consistent snapshot. (An
+  // update in progress is fine: ReadMutablePropertyValue returns the old value.)
+  uint32_t area_serial = atomic_load_explicit(serial_pa->serial(), memory_order_acquire);
+  for (;;) {
+    for (size_t i = 0; i < count; ++i) {
+      uint32_t serial = ReadMutablePropertyValue(pis[i], values[i]);
+      if (serials != nullptr) serials[i] = serial;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t new_area_serial = atomic_load_explicit(serial_pa->serial(), memory_order_relaxed);
+    if (__predict_true(new_area_serial == area_serial)) {
+      return 0;
+    }
+    area_serial = new_area_serial;
+    // As in ReadMutablePropertyValue, make sure the next round of reads happens
+    // after the load of the new global serial.
+    atomic_thread_fence(memory_order_acquire);
+  }
+}
+
+static atomic_bool futex_waitv_unavailable;
+
+bool SystemProperties::WaitMultiple(const prop_info* const* pis, const uint32_t* old_serials,
+                                    size_t count, uint32_t* new_serials,
+                                    const timespec* relative_timeout) {
+  if (!initialized_ || count == 0 || count > FUTEX_WAITV_MAX) {
+    return false;
+  }
+
+  prop_area* serial_pa = contexts_->GetSerialPropArea();
+  if (serial_pa == nullptr) {
+    return false;
+  }
+
+  timespec abs_timeout;
+  if (relative_timeout != nullptr) {
+    absolute_timespec_from_timespec(abs_timeout, *relative_timeout, CLOCK_MONOTONIC);
+  }
+
+  futex_waitv waiters[FUTEX_WAITV_MAX];
+  for (size_t i = 0; i < count; ++i) {
+    waiters[i].val = old_serials[i];
+    waiters[i].uaddr = reinterpret_cast<uintptr_t>(&pis[i]->serial);
+    // The property areas are shared between processes, so these aren't private futexes.
+    waiters[i].flags = FUTEX_32;
+    waiters[i].__reserved = 0;
+  }
+
+  bool use_futex_waitv = !atomic_load_explicit(&futex_waitv_unavailable, memory_order_relaxed);
+  for (;;) {
+    // Read the global serial first, so that if we have to fall back to waiting on
+    // it we can't miss an update to one of our properties.
+    uint32_t area_serial = atomic_load_explicit(serial_pa->serial(), memory_order_acquire);
+    bool changed = false;
+    for (size_t i = 0; i < count; ++i) {
+      new_serials[i] = load_const_atomic(&pis[i]->serial, memory_order_acquire);
+      if (new_serials[i] != old_serials[i]) changed = true;
+    }
+    if (changed) {
+      return true;
+    }
+
+    int rc;
+    if (use_futex_waitv) {
+      // Only wakes up when one of our properties changes.
+      rc = __futex_waitv(waiters, count, relative_timeout != nullptr ? &abs_timeout : nullptr);
+      if (rc >= 0 || rc == -EINTR || rc == -EAGAIN) continue;
+      if (rc == -ETIMEDOUT) return false;
+      // Retrying any other error could spin forever without checking the timeout,
+      // so wait on the global serial instead. ENOSYS (before Linux 5.16) and EPERM
+      // (from a seccomp filter) won't go away, so don't try futex_waitv again.
+      if (rc == -ENOSYS || rc == -EPERM) {
+        atomic_store_explicit(&futex_waitv_unavailable, true, memory_order_relaxed);
+      }
+      use_futex_waitv = false;
+    }
+
+    // Without futex_waitv the best we can do is wait for any property to change
+    // and then check whether it was one of ours.
+    timespec remaining;
+    if (relative_timeout != nullptr) {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      remaining.tv_sec = abs_timeout.tv_sec - now.tv_sec;
+      remaining.tv_nsec = abs_timeout.tv_nsec - now.tv_nsec;
+      if (remaining.tv_nsec < 0) {
+        remaining.tv_sec--;
+        remaining.tv_nsec += NS_PER_S;
+      }
+      if (remaining.tv_sec < 0) return false;
+    }
+    rc = __futex_wait(serial_pa->serial(), area_serial,
+                      relative_timeout != nullptr ? &remaining : nullptr);
+    if (rc == -ETIMEDOUT) return false;
+  }
+}
+
 const prop_info* SystemProperties::FindNth(unsigned n) {
   struct find_nth {
     const uint32_t sought;
@@ -462,3 +599,32 @@ int SystemProperties::Foreach(void (*propfn)(const prop_info* pi, void* cookie),
 
   return 0;
 }
+
+int SystemProperties::ForeachContext(void (*callback)(const prop_context_stats* stats,
+                                                      void* cookie),
+                                     void* cookie) {
+  if (!initialized_) {
+    return -1;
+  }
+
+  struct state {
+    void (*callback)(const prop_context_stats* stats, void* cookie);
+    void* cookie;
+  } s = {callback, cookie};
+  contexts_->ForEachContext(
+      [](const ContextNode* node, void* ptr) {
+        auto* s = reinterpret_cast<state*>(ptr);
+        const prop_area* pa = node->pa();
+        prop_context_stats stats = {
+            .context = node->context(),
+            .mapped_size = pa ? prop_area::pa_size() : 0,
+            .map_count = node->map_count(),
+            .lookup_count = node->lookup_count(),
+            .bytes_used = pa ? pa->bytes_used() : 0,
+            .bytes_total = pa ? static_cast<uint32_t>(prop_area::pa_data_size()) : 0,
+        };
+        s->callback(&stats, s->cookie);
+      },
+      &s);
+  return 0;
+}
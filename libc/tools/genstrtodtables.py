@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# Generates libc/bionic/strtod_tables.h, the table of 128-bit truncated
+# powers of five used by the Eisel-Lemire fast path in libc/bionic/strtod.cpp.
+#
+# usage: genstrtodtables.py > libc/bionic/strtod_tables.h
+
+SMALLEST_POWER = -342
+LARGEST_POWER = 308
+
+HEADER = """\
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// Generated by libc/tools/genstrtodtables.py. Do not edit.
+
+#pragma once
+
+#include <stdint.h>
+
+// The most significant 128 bits of 5^q for q in [%d, %d], normalized so that
+// the top bit is set. Negative powers are rounded up, positive powers are
+// truncated. Each entry is stored as a {high, low} pair of 64-bit words.
+static constexpr int kSmallestPowerOfFive = %d;
+static constexpr int kLargestPowerOfFive = %d;
+
+static const uint64_t kPowersOfFive128[] = {"""
+
+
+def power_of_five_128(q):
+    if q < 0:
+        power5 = 5 ** -q
+        z = 0
+        while (1 << z) < power5:
+            z += 1
+        if q >= -27:
+            b = z + 127
+            c = 2 ** b // power5 + 1
+        else:
+            b = 2 * z + 2 * 64
+            c = 2 ** b // power5 + 1
+            while c >= (1 << 128):
+                c //= 2
+        return c
+    power5 = 5 ** q
+    while power5 < (1 << 127):
+        power5 *= 2
+    while power5 >= (1 << 128):
+        power5 //= 2
+    return power5
+
+
+def main():
+    print(HEADER % (SMALLEST_POWER, LARGEST_POWER, SMALLEST_POWER, LARGEST_POWER))
+    for q in range(SMALLEST_POWER, LARGEST_POWER + 1):
+        c = power_of_five_128(q)
+        print("    0x%016xULL, 0x%016xULL,  // 5^%d" % (c >> 64, c & ((1 << 64) - 1), q))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
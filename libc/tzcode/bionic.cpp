@@ -29,15 +29,22 @@
 #include <arpa/inet.h> // For ntohl(3).
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <atomic>
+
 #include "private/CachedProperty.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
 extern "C" void tzset_unlocked(void);
 extern "C" void __bionic_get_system_tz(char* buf, size_t n);
-extern "C" int __bionic_open_tzdata(const char*, int32_t*);
+extern "C" uint64_t __bionic_system_tz_serial(void);
+extern "C" ssize_t __bionic_read_tzdata(const char*, void*, size_t);
 
 extern "C" void tzsetlcl(char const*);
 
@@ -75,6 +82,30 @@ void __bionic_get_system_tz(char* buf, size_t n) {
   }
 }
 
+// Returns a value that changes whenever __bionic_get_system_tz's result might
+// have, without taking any locks, so that localtime(3) can cheaply check that
+// the zone it used last time is still the right one.
+uint64_t __bionic_system_tz_serial() {
+  static std::atomic<const prop_info*> g_prop_info;
+  static std::atomic<uint32_t> g_area_serial;
+
+  const prop_info* pi = g_prop_info.load(std::memory_order_acquire);
+  if (pi == nullptr) {
+    // Until the property exists, any new property might be it, and the
+    // property area's serial changes when one is added. `__system_property_find`
+    // is expensive, so only retry when that happens.
+    uint32_t area_serial = __system_property_area_serial();
+    if (area_serial == g_area_serial.load(std::memory_order_relaxed)) return area_serial;
+    pi = __system_property_find("persist.sys.timezone");
+    if (pi == nullptr) {
+      g_area_serial.store(area_serial, std::memory_order_relaxed);
+      return area_serial;
+    }
+    g_prop_info.store(pi, std::memory_order_release);
+  }
+  return (UINT64_C(1) << 32) | __system_property_serial(pi);
+}
+
 void tzset_unlocked() {
   // The TZ environment variable is meant to override the system-wide setting.
   const char* name = getenv("TZ");
@@ -124,158 +155,192 @@ struct index_entry_t {
   int32_t unused; // Was raw GMT offset; always 0 since tzdata2014f (L).
 };
 
-// Returns -2 for a soft failure (where the caller should try another file),
-// -1 for a hard failure (where the caller should give up), and >= 0 is a
-// file descriptor whose offset points to the data for the given olson id in
-// the given file (and *entry_length is the size of the data).
-static int __bionic_open_tzdata_path(const char* path,
-                                     const char* olson_id,
-                                     int32_t* entry_length) {
+// Each tzdata file is mapped the first time it's needed and stays mapped for
+// the life of the process (tzdata updates only take effect after a reboot).
+// A file that couldn't be mapped is retried next time, because early in boot
+// the tzdata module may not have been mounted yet.
+struct tzdata_file_t {
+  char* path;  // nullptr until the file has been mapped.
+  const char* data;
+  size_t size;
+  const index_entry_t* index;
+  size_t id_count;
+  uint32_t data_offset;
+  bool index_sorted;
+};
+
+static pthread_mutex_t g_tzdata_lock = PTHREAD_MUTEX_INITIALIZER;
+static tzdata_file_t g_tzdata_files[2];
+
+// Returns false for a soft failure (where the caller should try another file).
+static bool __bionic_map_tzdata_path(const char* path, tzdata_file_t* file) {
+  if (file->path != nullptr) {
+    // On the host the path comes from the environment, so it can change.
+    if (strcmp(file->path, path) == 0) return true;
+    munmap(const_cast<char*>(file->data), file->size);
+    free(file->path);
+    *file = {};
+  }
+
   int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
   if (fd == -1) {
     // We don't log here, because this is quite common --- current devices
     // aren't expected to have the old APK tzdata, for example.
-    return -2;
+    return false;
   }
 
-  bionic_tzdata_header_t header = {};
-  ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, &header, sizeof(header)));
-  if (bytes_read != sizeof(header)) {
-    fprintf(stderr, "%s: could not read header of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    fprintf(stderr, "%s: couldn't stat \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
     close(fd);
-    return -2;
+    return false;
   }
-
-  if (strncmp(header.tzdata_version, "tzdata", 6) != 0 || header.tzdata_version[11] != 0) {
-    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n", __FUNCTION__, path, header.tzdata_version);
+  size_t size = sb.st_size;
+  if (size < sizeof(bionic_tzdata_header_t)) {
+    fprintf(stderr, "%s: could not read header of \"%s\": short read\n", __FUNCTION__, path);
     close(fd);
-    return -2;
+    return false;
   }
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, ntohl(header.index_offset), SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: couldn't seek to index in \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
-    close(fd);
-    return -2;
+  void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "%s: couldn't map \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
+    return false;
   }
+  const char* data = static_cast<const char*>(map);
 
-  if (ntohl(header.index_offset) > ntohl(header.data_offset)) {
+  bionic_tzdata_header_t header;
+  memcpy(&header, data, sizeof(header));
+  if (strncmp(header.tzdata_version, "tzdata", 6) != 0 || header.tzdata_version[11] != 0) {
+    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n", __FUNCTION__, path, header.tzdata_version);
+    munmap(map, size);
+    return false;
+  }
+
+  uint32_t index_offset = ntohl(header.index_offset);
+  uint32_t data_offset = ntohl(header.data_offset);
+  if (index_offset > data_offset || data_offset > size) {
     fprintf(stderr, "%s: invalid data and index offsets in \"%s\": %u %u\n",
-            __FUNCTION__, path, ntohl(header.data_offset), ntohl(header.index_offset));
-    close(fd);
-    return -2;
+            __FUNCTION__, path, data_offset, index_offset);
+    munmap(map, size);
+    return false;
   }
-  const size_t index_size = ntohl(header.data_offset) - ntohl(header.index_offset);
-  if ((index_size % sizeof(index_entry_t)) != 0) {
+  const size_t index_size = data_offset - index_offset;
+  if ((index_size % sizeof(index_entry_t)) != 0 || (index_offset % alignof(index_entry_t)) != 0) {
     fprintf(stderr, "%s: invalid index size in \"%s\": %zd\n", __FUNCTION__, path, index_size);
-    close(fd);
-    return -2;
+    munmap(map, size);
+    return false;
   }
 
-  char* index = reinterpret_cast<char*>(malloc(index_size));
-  if (index == nullptr) {
-    fprintf(stderr, "%s: couldn't allocate %zd-byte index for \"%s\"\n", __FUNCTION__, index_size, path);
-    close(fd);
-    return -2;
+  file->path = strdup(path);
+  if (file->path == nullptr) {
+    munmap(map, size);
+    return false;
   }
-  if (TEMP_FAILURE_RETRY(read(fd, index, index_size)) != static_cast<ssize_t>(index_size)) {
-    fprintf(stderr, "%s: could not read index of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
-    free(index);
-    close(fd);
-    return -2;
+  file->data = data;
+  file->size = size;
+  file->index = reinterpret_cast<const index_entry_t*>(data + index_offset);
+  file->id_count = index_size / sizeof(index_entry_t);
+  file->data_offset = data_offset;
+
+  // ZoneCompactor writes the index in sorted order, but we don't rely on it.
+  file->index_sorted = true;
+  for (size_t i = 1; i < file->id_count; ++i) {
+    if (strncmp(file->index[i - 1].buf, file->index[i].buf, NAME_LENGTH) >= 0) {
+      file->index_sorted = false;
+      break;
+    }
   }
+  return true;
+}
 
-  off_t specific_zone_offset = -1;
-  size_t id_count = index_size / sizeof(index_entry_t);
-  index_entry_t* entry = reinterpret_cast<index_entry_t*>(index);
-  for (size_t i = 0; i < id_count; ++i) {
-    char this_id[NAME_LENGTH + 1];
-    memcpy(this_id, entry->buf, NAME_LENGTH);
-    this_id[NAME_LENGTH] = '\0';
-
-    if (strcmp(this_id, olson_id) == 0) {
-      specific_zone_offset = ntohl(entry->start) + ntohl(header.data_offset);
-      *entry_length = ntohl(entry->length);
-      break;
+static const index_entry_t* __bionic_find_tzdata_entry(const tzdata_file_t& file,
+                                                       const char* olson_id) {
+  // Names are NUL-padded to NAME_LENGTH bytes, but needn't be NUL-terminated.
+  if (strlen(olson_id) > NAME_LENGTH) return nullptr;
+
+  if (!file.index_sorted) {
+    for (size_t i = 0; i < file.id_count; ++i) {
+      if (strncmp(olson_id, file.index[i].buf, NAME_LENGTH) == 0) return &file.index[i];
     }
+    return nullptr;
+  }
 
-    ++entry;
+  size_t lo = 0;
+  size_t hi = file.id_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strncmp(olson_id, file.index[mid].buf, NAME_LENGTH);
+    if (cmp == 0) return &file.index[mid];
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
   }
-  free(index);
+  return nullptr;
+}
 
-  if (specific_zone_offset == -1) {
+// Copies the data for the given olson id in the given file to `buf`, and
+// returns its length (or -1 with errno set).
+static ssize_t __bionic_read_tzdata_entry(const tzdata_file_t& file, const char* olson_id,
+                                          void* buf, size_t buf_size) {
+  const index_entry_t* entry = __bionic_find_tzdata_entry(file, olson_id);
+  if (entry == nullptr) {
     // We found a valid tzdata file, but didn't find the requested id in it.
     // Give up now, and don't try fallback tzdata files. We don't log here
     // because for all we know the given olson id was nonsense.
-    close(fd);
-    // This file descriptor (-1) is passed to localtime.c. In invalid fd case
-    // upstream passes errno value around methods and having 0 there will
-    // indicate that timezone was found and read successfully and localtime's
-    // internal state was properly initialized (which wasn't as we couldn't find
-    // requested timezone in the tzdata file).
-    // If we reached this point errno is unlikely to be touched. It is only
-    // close(fd) which can do it, but that is very unlikely to happen. And
-    // even if it happens we can't extract any useful insights from it.
-    // We are overriding it to ENOENT as it matches upstream expectations -
-    // timezone is absent in the tzdata file == there is no TZif file in
-    // /usr/share/zoneinfo.
+    // We use ENOENT as it matches upstream expectations - timezone is absent
+    // in the tzdata file == there is no TZif file in /usr/share/zoneinfo.
     errno = ENOENT;
     return -1;
   }
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, specific_zone_offset, SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: could not seek to %ld in \"%s\": %s\n",
-            __FUNCTION__, specific_zone_offset, path, strerror(errno));
-    close(fd);
-    return -2;
+  size_t start = static_cast<size_t>(file.data_offset) + ntohl(entry->start);
+  size_t length = ntohl(entry->length);
+  if (start > file.size || length > file.size - start) {
+    fprintf(stderr, "%s: invalid entry for %s in \"%s\"\n", __FUNCTION__, olson_id, file.path);
+    errno = EINVAL;
+    return -1;
   }
 
-  return fd;
+  if (length > buf_size) length = buf_size;
+  memcpy(buf, file.data + start, length);
+  return length;
 }
 
-int __bionic_open_tzdata(const char* olson_id, int32_t* entry_length) {
-  int fd;
+ssize_t __bionic_read_tzdata(const char* olson_id, void* buf, size_t buf_size) {
+  ScopedPthreadMutexLocker locker(&g_tzdata_lock);
 
   // Try the two locations for the tzdata file in a strict order:
   // 1: The timezone data module which contains the main copy. This is the
   //    common case for current devices.
   // 2: The ultimate fallback: the non-updatable copy in /system.
-
+  for (size_t i = 0; i < 2; ++i) {
 #if defined(__ANDROID__)
-  // On Android devices, bionic has to work even if exec takes place without
-  // environment variables set. So, all paths are hardcoded here.
-  fd = __bionic_open_tzdata_path("/apex/com.android.tzdata/etc/tz/tzdata",
-                                 olson_id, entry_length);
-  if (fd >= -1) return fd;
-
-  fd = __bionic_open_tzdata_path("/system/usr/share/zoneinfo/tzdata",
-                                 olson_id, entry_length);
-  if (fd >= -1) return fd;
+    // On Android devices, bionic has to work even if exec takes place without
+    // environment variables set. So, all paths are hardcoded here.
+    const char* path = (i == 0) ? "/apex/com.android.tzdata/etc/tz/tzdata"
+                                : "/system/usr/share/zoneinfo/tzdata";
+    bool mapped = __bionic_map_tzdata_path(path, &g_tzdata_files[i]);
 #else
-  // On the host, we don't expect the hard-coded locations above to exist, and
-  // we're not worried about security so we trust $ANDROID_TZDATA_ROOT, and
-  // $ANDROID_ROOT to point us in the right direction instead.
-
-  char* path = make_path("ANDROID_TZDATA_ROOT", "/etc/tz/tzdata");
-  fd = __bionic_open_tzdata_path(path, olson_id, entry_length);
-  free(path);
-  if (fd >= -1) return fd;
-
-  path = make_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata");
-  fd = __bionic_open_tzdata_path(path, olson_id, entry_length);
-  free(path);
-  if (fd >= -1) return fd;
+    // On the host, we don't expect the hard-coded locations above to exist, and
+    // we're not worried about security so we trust $ANDROID_TZDATA_ROOT, and
+    // $ANDROID_ROOT to point us in the right direction instead.
+    char* path = (i == 0) ? make_path("ANDROID_TZDATA_ROOT", "/etc/tz/tzdata")
+                          : make_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata");
+    bool mapped = __bionic_map_tzdata_path(path, &g_tzdata_files[i]);
+    free(path);
 #endif
+    if (mapped) return __bionic_read_tzdata_entry(g_tzdata_files[i], olson_id, buf, buf_size);
+  }
 
   // Not finding any tzdata is more serious that not finding a specific zone,
   // and worth logging.
-  if (fd == -2) {
-    // The first thing that 'recovery' does is try to format the current time. It doesn't have
-    // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
-    fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
-  }
-
-  // Otherwise we were successful.
-  return fd;
+  // The first thing that 'recovery' does is try to format the current time. It doesn't have
+  // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
+  fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
+  errno = ENOENT;
+  return -1;
 }
@@ -174,6 +174,227 @@ static struct state *const gmtptr = &gmtmem;
 static char lcl_TZname[TZ_STRLEN_MAX + 1];
 static int  lcl_is_set;
 
+#if defined(__BIONIC__)
+# include <stdatomic.h>
+
+/*
+** Android-added: localtime and mktime are called far more often than the
+** local time zone changes, so rather than take locallock for every call they
+** check, without locking, that the zone they used last time is still the
+** right one. So that the state they're reading isn't reloaded under them,
+** tzsetlcl switches lclptr between states kept per zone name instead of
+** reloading one state in place. The zone in use, and the serial of the
+** system property it came from (or LCL_SOURCE_TZ if it came from $TZ), are
+** published under a sequence lock.
+**
+** A process rarely sees more than a couple of zones, but one that keeps
+** changing $TZ mustn't grow without bound, so only the LCL_ZONES most
+** recently used are kept. Beyond that, the least recently used one that
+** isn't current or published is reloaded in place, inside the sequence
+** lock, and lock-free readers check the sequence again once they're done.
+** States are never freed, because struct tm's tm_zone points into them.
+*/
+enum { LCL_ZONES = 8 };
+
+enum lcl_zone_kind {
+  LCL_ZONE_SYSTEM,	/* $TZ wasn't set.  */
+  LCL_ZONE_NAMED,	/* $TZ was NAME.  */
+  LCL_ZONE_UNNAMED	/* $TZ was too long to keep.  */
+};
+
+struct lcl_zone {
+  unsigned long last_used;
+  enum lcl_zone_kind kind;
+  char name[TZ_STRLEN_MAX + 1];
+  struct state state;
+};
+
+/* Guarded by locallock.  */
+static struct lcl_zone *lcl_zones[LCL_ZONES];
+static struct lcl_zone *lcl_current_zone;
+static unsigned long lcl_uses;
+
+#define LCL_SOURCE_TZ UINT64_MAX
+
+static atomic_uint lcl_seq;
+static struct lcl_zone *_Atomic lcl_published_zone;
+static _Atomic uint64_t lcl_published_source;
+
+/*
+** The transition interval this thread most recently found in the local zone.
+** Successive calls usually land in the same one, so this saves the binary
+** search. Only the published zone's state is cached, tagged with the
+** sequence number, since the state may be reloaded with a different zone
+** once it's no longer published.
+*/
+static __thread struct {
+  struct state const *sp;
+  unsigned seq;
+  time_t lo;
+  time_t hi;
+  int type;
+} lcl_interval;
+
+extern uint64_t __bionic_system_tz_serial(void);
+static int zoneinit(struct state *, char const *);
+
+static uint64_t
+lcl_source(void)
+{
+  return getenv("TZ") ? LCL_SOURCE_TZ : __bionic_system_tz_serial();
+}
+
+static bool
+lcl_zone_matches(struct lcl_zone const *z, char const *name)
+{
+  if (!name)
+    return z->kind == LCL_ZONE_SYSTEM;
+  return z->kind == LCL_ZONE_NAMED && strcmp(z->name, name) == 0;
+}
+
+static struct state *
+lcl_zone_get(char const *name)
+{
+  struct lcl_zone *published = atomic_load_explicit(&lcl_published_zone,
+						    memory_order_relaxed);
+  struct lcl_zone *z = NULL;
+  bool reuse = false;
+  unsigned seq = 0;
+  int i;
+
+  for (i = 0; i < LCL_ZONES && lcl_zones[i]; i++)
+    if (lcl_zone_matches(lcl_zones[i], name)) {
+      z = lcl_zones[i];
+      break;
+    }
+  if (!z) {
+    if (i < LCL_ZONES) {
+      z = lcl_zones[i] = malloc(sizeof *z);
+      if (!z) {
+	lcl_current_zone = NULL;
+	return NULL;
+      }
+    } else {
+      /*
+      ** Lock-free readers can only have found the published zone, or one
+      ** published before it. The former is never reused, and those still
+      ** reading the latter will see the sequence change.
+      */
+      for (i = 0; i < LCL_ZONES; i++)
+	if (lcl_zones[i] != lcl_current_zone && lcl_zones[i] != published
+	    && (!z || lcl_zones[i]->last_used < z->last_used))
+	  z = lcl_zones[i];
+      reuse = true;
+      seq = atomic_load_explicit(&lcl_seq, memory_order_relaxed);
+      atomic_store_explicit(&lcl_seq, seq + 1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+    }
+    if (!name)
+      z->kind = LCL_ZONE_SYSTEM;
+    else if (strlen(name) < sizeof z->name) {
+      z->kind = LCL_ZONE_NAMED;
+      strcpy(z->name, name);
+    } else
+      z->kind = LCL_ZONE_UNNAMED;
+    if (zoneinit(&z->state, name) != 0)
+      zoneinit(&z->state, "");
+    if (reuse)
+      atomic_store_explicit(&lcl_seq, seq + 2, memory_order_release);
+  }
+  z->last_used = ++lcl_uses;
+  lcl_current_zone = z;
+  return &z->state;
+}
+
+/* Called with locallock held, after tzset_unlocked.  */
+static void
+lcl_publish(uint64_t source)
+{
+  struct lcl_zone *z = lcl_current_zone;
+  unsigned seq;
+
+  if (z == atomic_load_explicit(&lcl_published_zone, memory_order_relaxed)
+      && source == atomic_load_explicit(&lcl_published_source,
+					memory_order_relaxed))
+    return;
+  seq = atomic_load_explicit(&lcl_seq, memory_order_relaxed);
+  atomic_store_explicit(&lcl_seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&lcl_published_zone, z, memory_order_relaxed);
+  atomic_store_explicit(&lcl_published_source, source, memory_order_relaxed);
+  atomic_store_explicit(&lcl_seq, seq + 2, memory_order_release);
+}
+
+/* Returns the published zone's state, which may no longer be the local zone.  */
+static struct state const *
+lcl_published_state_unchecked(void)
+{
+  struct lcl_zone *z = atomic_load_explicit(&lcl_published_zone,
+					    memory_order_relaxed);
+  return z ? &z->state : NULL;
+}
+
+/*
+** Returns the local zone's state if it can be used without locking, and sets
+** *SEQP for lcl_still_published.
+*/
+static struct state const *
+lcl_published_state(unsigned *seqp)
+{
+  unsigned seq = atomic_load_explicit(&lcl_seq, memory_order_acquire);
+  struct lcl_zone *z = atomic_load_explicit(&lcl_published_zone,
+					    memory_order_relaxed);
+  uint64_t source = atomic_load_explicit(&lcl_published_source,
+					 memory_order_relaxed);
+  char const *tz;
+
+  atomic_thread_fence(memory_order_acquire);
+  if ((seq & 1) || seq != atomic_load_explicit(&lcl_seq, memory_order_relaxed)
+      || !z)
+    return NULL;
+  tz = getenv("TZ");
+  if (tz
+      ? !lcl_zone_matches(z, tz)
+      : source != __bionic_system_tz_serial())
+    return NULL;
+  *seqp = seq;
+  return &z->state;
+}
+
+/*
+** Whether the state lcl_published_state returned wasn't reloaded while the
+** caller was using it.
+*/
+static bool
+lcl_still_published(unsigned seq)
+{
+  atomic_thread_fence(memory_order_acquire);
+  return seq == atomic_load_explicit(&lcl_seq, memory_order_relaxed);
+}
+
+/*
+** Whether update_tzname_etc would leave tzname etc. as they are for a time
+** that localsub converted to TMP. If not, the caller has to take the lock.
+*/
+static bool
+lcl_tzname_is_current(struct tm const *tmp)
+{
+#if HAVE_TZNAME
+  if (tzname[tmp->tm_isdst] != tmp->TM_ZONE)
+    return false;
+#endif
+#if USG_COMPAT
+  if (!tmp->tm_isdst && timezone != -tmp->TM_GMTOFF)
+    return false;
+#endif
+#if ALTZONE
+  if (tmp->tm_isdst && altzone != -tmp->TM_GMTOFF)
+    return false;
+#endif
+  return true;
+}
+#endif
+
 /*
 ** Section 4.12.3 of X3.159-1989 requires that
 **  Except for the strftime function, these functions [asctime,
@@ -409,7 +630,9 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	   union local_storage *lsp)
 {
 	register int			i;
+#if !defined(__BIONIC__)
 	register int			fid;
+#endif
 	register int			stored;
 	register ssize_t		nread;
 #if !defined(__BIONIC__)
@@ -435,9 +658,11 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	}
 
 #if defined(__BIONIC__)
-	extern int __bionic_open_tzdata(const char*, int32_t*);
-	int32_t entry_length;
-	fid = __bionic_open_tzdata(name, &entry_length);
+	// Android-changed: the zones are all in one mmapped tzdata file.
+	extern ssize_t __bionic_read_tzdata(const char*, void*, size_t);
+	nread = __bionic_read_tzdata(name, up->buf, sizeof up->buf);
+	if (nread < tzheadsize)
+	  return nread < 0 ? errno : EINVAL;
 #else
 	if (name[0] == ':')
 		++name;
@@ -474,15 +699,10 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	if (doaccess && access(name, R_OK) != 0)
 	  return errno;
   fid = open(name, O_RDONLY | O_BINARY);
-#endif
 	if (fid < 0)
 	  return errno;
 
-#if defined(__BIONIC__)
-	nread = TEMP_FAILURE_RETRY(read(fid, up->buf, entry_length));
-#else
 	nread = read(fid, up->buf, sizeof up->buf);
-#endif
 	if (nread < tzheadsize) {
 	  int err = nread < 0 ? errno : EINVAL;
 	  close(fid);
@@ -490,6 +710,7 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	}
 	if (close(fid) < 0)
 	  return errno;
+#endif
 	for (stored = 4; stored <= 8; stored *= 2) {
 	    char version = up->tzhead.tzh_version[0];
 	    bool skip_datablock = stored == 4 && version;
@@ -1460,6 +1681,10 @@ tzsetlcl(char const *name)
       ? lcl_is_set < 0
       : 0 < lcl_is_set && strcmp(lcl_TZname, name) == 0)
     return;
+#if defined(__BIONIC__)
+  lclptr = sp = lcl_zone_get(name);
+  if (sp) {
+#else
 #ifdef ALL_STATE
   if (! sp)
     lclptr = sp = malloc(sizeof *lclptr);
@@ -1467,6 +1692,7 @@ tzsetlcl(char const *name)
   if (sp) {
     if (zoneinit(sp, name) != 0)
       zoneinit(sp, "");
+#endif
     if (0 < lcl)
       strcpy(lcl_TZname, name);
   }
@@ -1512,17 +1738,89 @@ gmtcheck(void)
 
 #if NETBSD_INSPIRED
 
+#if defined(__BIONIC__)
+// Android-added: services that format times in many different zones call
+// tzalloc over and over for the same few zones, so keep the most recently
+// loaded ones around rather than parsing their data again each time. The
+// zones' contents can't change until the next boot (when a new tzdata
+// takes effect), so entries never go stale. Only tzalloc uses this, so
+// processes that only ever use the local zone don't pay for it.
+enum { ZONE_CACHE_SIZE = 8 };
+
+struct zone_cache_entry {
+  char name[TZ_STRLEN_MAX + 1];
+  struct state *sp;
+};
+
+static pthread_mutex_t zone_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Most recently used first.  */
+static struct zone_cache_entry zone_cache[ZONE_CACHE_SIZE];
+
+static bool
+zone_cache_get(char const *name, struct state *sp)
+{
+  bool found = false;
+  pthread_mutex_lock(&zone_cache_lock);
+  for (int i = 0; i < ZONE_CACHE_SIZE && zone_cache[i].sp; i++) {
+    if (strcmp(zone_cache[i].name, name) == 0) {
+      struct zone_cache_entry hit = zone_cache[i];
+      memcpy(sp, hit.sp, sizeof *sp);
+      memmove(&zone_cache[1], &zone_cache[0], i * sizeof zone_cache[0]);
+      zone_cache[0] = hit;
+      found = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&zone_cache_lock);
+  return found;
+}
+
+static void
+zone_cache_put(char const *name, struct state const *sp)
+{
+  struct state *copy = malloc(sizeof *copy);
+  if (!copy)
+    return;
+  memcpy(copy, sp, sizeof *copy);
+  pthread_mutex_lock(&zone_cache_lock);
+  for (int i = 0; i < ZONE_CACHE_SIZE && zone_cache[i].sp; i++) {
+    if (strcmp(zone_cache[i].name, name) == 0) {
+      /* Another thread got here first.  */
+      pthread_mutex_unlock(&zone_cache_lock);
+      free(copy);
+      return;
+    }
+  }
+  struct state *evicted = zone_cache[ZONE_CACHE_SIZE - 1].sp;
+  memmove(&zone_cache[1], &zone_cache[0], (ZONE_CACHE_SIZE - 1) * sizeof zone_cache[0]);
+  strcpy(zone_cache[0].name, name);
+  zone_cache[0].sp = copy;
+  pthread_mutex_unlock(&zone_cache_lock);
+  free(evicted);
+}
+#endif
+
 timezone_t
 tzalloc(char const *name)
 {
   timezone_t sp = malloc(sizeof *sp);
   if (sp) {
+#if defined(__BIONIC__)
+    // A null name means the system zone, which can change.
+    bool cacheable = name && strlen(name) < sizeof zone_cache[0].name;
+    if (cacheable && zone_cache_get(name, sp))
+      return sp;
+#endif
     int err = zoneinit(sp, name);
     if (err != 0) {
       free(sp);
       errno = err;
       return NULL;
     }
+#if defined(__BIONIC__)
+    if (cacheable)
+      zone_cache_put(name, sp);
+#endif
   } else if (!HAVE_MALLOC_ERRNO)
     errno = ENOMEM;
   return sp;
@@ -1623,6 +1921,13 @@ localsub(struct state const *sp, time_t const *timep, int_fast32_t setname,
 	}
 	if (sp->timecnt == 0 || t < sp->ats[0]) {
 		i = sp->defaulttype;
+#if defined(__BIONIC__)
+	} else if (sp == lcl_interval.sp && lcl_interval.lo <= t
+		   && t < lcl_interval.hi
+		   && lcl_interval.seq == atomic_load_explicit(&lcl_seq,
+							       memory_order_relaxed)) {
+		i = lcl_interval.type;
+#endif
 	} else {
 		register int	lo = 1;
 		register int	hi = sp->timecnt;
@@ -1635,6 +1940,16 @@ localsub(struct state const *sp, time_t const *timep, int_fast32_t setname,
 			else	lo = mid + 1;
 		}
 		i = sp->types[lo - 1];
+#if defined(__BIONIC__)
+		if (sp == lcl_published_state_unchecked()) {
+		  lcl_interval.sp = sp;
+		  lcl_interval.seq = atomic_load_explicit(&lcl_seq,
+							  memory_order_relaxed);
+		  lcl_interval.lo = sp->ats[lo - 1];
+		  lcl_interval.hi = lo < sp->timecnt ? sp->ats[lo] : TIME_T_MAX;
+		  lcl_interval.type = i;
+		}
+#endif
 	}
 	ttisp = &sp->ttis[i];
 	/*
@@ -1669,6 +1984,17 @@ localtime_rz(struct state *restrict sp, time_t const *restrict timep,
 static struct tm *
 localtime_tzset(time_t const *timep, struct tm *tmp)
 {
+#if defined(__BIONIC__)
+  unsigned seq;
+  struct state const *sp = lcl_published_state(&seq);
+  if (sp) {
+    struct tm *result = localsub(sp, timep, false, tmp);
+    if (result && lcl_tzname_is_current(result) && lcl_still_published(seq))
+      return result;
+  }
+  uint64_t source;
+#endif
+
   int err = lock();
   if (err) {
     errno = err;
@@ -1680,7 +2006,13 @@ localtime_tzset(time_t const *timep, struct tm *tmp)
   // the "not required to set tzname" clause). It's unclear that POSIX actually intended this,
   // the BSDs disagree with glibc, and it's confusing to developers to have localtime_r(3)
   // behave differently than other time zone-sensitive functions in <time.h>.
+#if defined(__BIONIC__)
+  source = lcl_source();
+#endif
   tzset_unlocked();
+#if defined(__BIONIC__)
+  lcl_publish(source);
+#endif
 
   tmp = localsub(lclptr, timep, true, tmp);
   unlock();
@@ -2349,12 +2681,35 @@ mktime(struct tm *tmp)
 #endif
 
   time_t t;
+#if defined(__BIONIC__)
+  unsigned seq;
+  struct state const *sp = lcl_published_state(&seq);
+  if (sp) {
+    // Work on a copy: if tzname etc. need updating, the locked path has to
+    // start again from the caller's fields.
+    struct tm tm = *tmp;
+    t = mktime_tzname((struct state *) sp, &tm, false);
+    if (t != -1 && lcl_tzname_is_current(&tm) && lcl_still_published(seq)) {
+      *tmp = tm;
+      errno = saved_errno;
+      return t;
+    }
+  }
+  uint64_t source;
+#endif
+
   int err = lock();
   if (err) {
     errno = err;
     return -1;
   }
+#if defined(__BIONIC__)
+  source = lcl_source();
+#endif
   tzset_unlocked();
+#if defined(__BIONIC__)
+  lcl_publish(source);
+#endif
   t = mktime_tzname(lclptr, tmp, true);
   unlock();
 
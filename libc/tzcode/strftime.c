@@ -142,6 +142,379 @@ strftime_l(char *restrict s, size_t maxsize, char const *restrict format,
 
 #define FORCE_LOWER_CASE 0x100 /* Android extension. */
 
+#if defined(__BIONIC__)
+/*
+** Android-added: services such as logd format huge numbers of timestamps
+** with the same few formats, so rather than interpret the format on every
+** call, strftime parses it once into a plan of literal text and conversions,
+** and keeps the plans for the first few formats it sees. The common numeric
+** conversions are written from a table of digit pairs; everything else goes
+** through _fmt one conversion at a time. Plans are never freed, so they can
+** be looked up without locking. Only formats that use the time zone need
+** tzset, which otherwise takes a lock for every call.
+*/
+# include <pthread.h>
+# include <stdatomic.h>
+
+enum {
+  PLAN_FORMAT_MAX = 64,
+  PLAN_TEXT_MAX = 128,
+  PLAN_OPS_MAX = 40,
+  PLAN_CACHE_SIZE = 8,
+};
+
+/* Values of strftime_op.conv other than conversion characters.  */
+enum { OP_TEXT, OP_FMT };
+
+struct strftime_op {
+  /* OP_TEXT, OP_FMT, or a numeric conversion.  */
+  char conv;
+  char modifier;
+  /* The text to copy, or the "%..." to pass to _fmt, in plan->text.  */
+  unsigned char offset;
+  unsigned char length;
+  /* _conv's format, for numeric conversions.  */
+  char const *numfmt;
+};
+
+struct strftime_plan {
+  char format[PLAN_FORMAT_MAX];
+  char text[PLAN_TEXT_MAX];
+  struct strftime_op ops[PLAN_OPS_MAX];
+  int op_count;
+  int text_length;
+  bool uses_zone;
+  /* False if the format has too many parts for a plan.  */
+  bool usable;
+};
+
+static struct strftime_plan *_Atomic plan_cache[PLAN_CACHE_SIZE];
+static pthread_mutex_t plan_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *getformat(int, char *, char *, char *, char *);
+
+static struct strftime_op *
+plan_add(struct strftime_plan *plan, int conv, char const *text, int length)
+{
+  struct strftime_op *op = NULL;
+
+  if (plan->text_length + length > PLAN_TEXT_MAX)
+    return NULL;
+  /* Consecutive text is copied in one go.  */
+  if (conv == OP_TEXT && plan->op_count
+      && plan->ops[plan->op_count - 1].conv == OP_TEXT)
+    op = &plan->ops[plan->op_count - 1];
+  else if (plan->op_count < PLAN_OPS_MAX) {
+    op = &plan->ops[plan->op_count++];
+    op->conv = conv;
+    op->modifier = 0;
+    op->offset = plan->text_length;
+    op->length = 0;
+    op->numfmt = NULL;
+  }
+  if (op) {
+    memcpy(&plan->text[plan->text_length], text, length);
+    plan->text_length += length;
+    op->length += length;
+  }
+  return op;
+}
+
+static bool
+plan_compile(struct strftime_plan *plan, char const *format)
+{
+    struct lc_time_T const *Locale = &C_time_locale;
+    struct strftime_op *op;
+
+    for ( ; *format; ++format) {
+        if (*format == '%') {
+            char spec[4];
+            char const *numfmt;
+            int modifier = 0;
+label:
+            /* These cases mirror _fmt's.  */
+            switch (*++format) {
+            case '\0':
+                --format;
+                break;
+            case 'E':
+            case 'O':
+                goto label;
+            case '_':
+            case '-':
+            case '0':
+            case '^':
+            case '#':
+                modifier = *format;
+                goto label;
+            case 'D':
+                if (!plan_compile(plan, "%m/%d/%y"))
+                    return false;
+                continue;
+            case 'F':
+                if (!plan_compile(plan, "%Y-%m-%d"))
+                    return false;
+                continue;
+            case 'R':
+                if (!plan_compile(plan, "%H:%M"))
+                    return false;
+                continue;
+            case 'r':
+                if (!plan_compile(plan, "%I:%M:%S %p"))
+                    return false;
+                continue;
+            case 'T':
+                if (!plan_compile(plan, "%H:%M:%S"))
+                    return false;
+                continue;
+            case 'v':
+                if (!plan_compile(plan, "%e-%b-%Y"))
+                    return false;
+                continue;
+            case 'X':
+                if (!plan_compile(plan, Locale->X_fmt))
+                    return false;
+                continue;
+            case '+':
+                if (!plan_compile(plan, Locale->date_fmt))
+                    return false;
+                continue;
+            case 'C':
+            case 'd':
+            case 'H':
+            case 'I':
+            case 'M':
+            case 'm':
+            case 'S':
+            case 'U':
+            case 'W':
+            case 'Y':
+            case 'y':
+                numfmt = getformat(modifier, "02", " 2", "  ", "02");
+                goto numeric;
+            case 'e':
+            case 'k':
+            case 'l':
+                numfmt = getformat(modifier, " 2", " 2", "  ", "02");
+                goto numeric;
+            case 'j':
+                numfmt = getformat(modifier, "03", " 3", "  ", "03");
+                goto numeric;
+            case 'u':
+            case 'w':
+                numfmt = "  ";
+numeric:
+                op = plan_add(plan, *format, "", 0);
+                if (!op)
+                    return false;
+                op->modifier = modifier;
+                op->numfmt = numfmt;
+                continue;
+            case 'n':
+                if (!plan_add(plan, OP_TEXT, "\n", 1))
+                    return false;
+                continue;
+            case 't':
+                if (!plan_add(plan, OP_TEXT, "\t", 1))
+                    return false;
+                continue;
+            case 'Z':
+            case 'z':
+                plan->uses_zone = true;
+                /* FALLTHROUGH */
+            case 'A':
+            case 'a':
+            case 'B':
+            case 'b':
+            case 'h':
+            case 'c':
+            case 'G':
+            case 'g':
+            case 'V':
+            case 'P':
+            case 'p':
+            case 's':
+            case 'x':
+                spec[0] = '%';
+                spec[1] = modifier ? modifier : *format;
+                spec[2] = modifier ? *format : '\0';
+                spec[3] = '\0';
+                if (!plan_add(plan, OP_FMT, spec, sizeof spec))
+                    return false;
+                continue;
+            default:
+                break;
+            }
+        }
+        if (!plan_add(plan, OP_TEXT, format, 1))
+            return false;
+    }
+    return true;
+}
+
+static struct strftime_plan const *
+plan_get(char const *format)
+{
+  struct strftime_plan *plan;
+  int i;
+
+  for (i = 0; i < PLAN_CACHE_SIZE; i++) {
+    plan = atomic_load_explicit(&plan_cache[i], memory_order_acquire);
+    if (!plan)
+      break;
+    if (strcmp(plan->format, format) == 0)
+      return plan->usable ? plan : NULL;
+  }
+  if (i == PLAN_CACHE_SIZE || strlen(format) >= PLAN_FORMAT_MAX)
+    return NULL;
+
+  plan = malloc(sizeof *plan);
+  if (!plan)
+    return NULL;
+  strcpy(plan->format, format);
+  plan->op_count = 0;
+  plan->text_length = 0;
+  plan->uses_zone = false;
+  plan->usable = plan_compile(plan, format);
+
+  pthread_mutex_lock(&plan_cache_lock);
+  for ( ; i < PLAN_CACHE_SIZE; i++) {
+    struct strftime_plan *other =
+      atomic_load_explicit(&plan_cache[i], memory_order_relaxed);
+    if (!other) {
+      atomic_store_explicit(&plan_cache[i], plan, memory_order_release);
+      break;
+    }
+    if (strcmp(other->format, format) == 0) {
+      /* Another thread got there first.  */
+      free(plan);
+      plan = other;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&plan_cache_lock);
+
+  if (i == PLAN_CACHE_SIZE) {
+    free(plan);
+    return NULL;
+  }
+  return plan->usable ? plan : NULL;
+}
+
+/* Like _conv, but without the intermediate buffer for 0-99.  */
+static char *
+_conv_fast(int n, const char *format, char *pt, const char *ptlim)
+{
+  static char const digit_pairs[] =
+"00010203040506070809"
+"10111213141516171819"
+"20212223242526272829"
+"30313233343536373839"
+"40414243444546474849"
+"50515253545556575859"
+"60616263646566676869"
+"70717273747576777879"
+"80818283848586878889"
+"90919293949596979899";
+  char const *d;
+
+  if (n < 0 || 100 <= n || '2' < format[1] || ptlim - pt < 2)
+    return _conv(n, format, pt, ptlim);
+  d = &digit_pairs[2 * n];
+  if (10 <= n)
+    *pt++ = d[0];
+  else if (format[1] == '2')
+    *pt++ = format[0];
+  *pt++ = d[1];
+  return pt;
+}
+
+static char *
+plan_exec(struct strftime_plan const *plan, const struct tm *t, char *pt,
+          const char *ptlim, enum warn *warnp)
+{
+    int i;
+
+    for (i = 0; i < plan->op_count; i++) {
+        struct strftime_op const *op = &plan->ops[i];
+        char const *text = &plan->text[op->offset];
+        int n;
+
+        switch (op->conv) {
+        case OP_TEXT:
+            for (n = 0; n < op->length; n++) {
+                if (pt == ptlim)
+                    return pt;
+                *pt++ = text[n];
+            }
+            continue;
+        case OP_FMT:
+            pt = _fmt(text, t, pt, ptlim, warnp);
+            continue;
+        case 'd':
+        case 'e':
+            n = t->tm_mday;
+            break;
+        case 'H':
+        case 'k':
+            n = t->tm_hour;
+            break;
+        case 'I':
+        case 'l':
+            n = (t->tm_hour % 12) ? (t->tm_hour % 12) : 12;
+            break;
+        case 'j':
+            n = t->tm_yday + 1;
+            break;
+        case 'M':
+            n = t->tm_min;
+            break;
+        case 'm':
+            n = t->tm_mon + 1;
+            break;
+        case 'S':
+            n = t->tm_sec;
+            break;
+        case 'U':
+            n = (t->tm_yday + DAYSPERWEEK - t->tm_wday) / DAYSPERWEEK;
+            break;
+        case 'u':
+            n = (t->tm_wday == 0) ? DAYSPERWEEK : t->tm_wday;
+            break;
+        case 'W':
+            n = (t->tm_yday + DAYSPERWEEK -
+                 (t->tm_wday ? (t->tm_wday - 1) : (DAYSPERWEEK - 1))) /
+                DAYSPERWEEK;
+            break;
+        case 'w':
+            n = t->tm_wday;
+            break;
+        case 'y':
+            *warnp = IN_ALL;
+            /* FALLTHROUGH */
+        case 'C':
+        case 'Y':
+            /* _yconv gives the same answer for these years.  */
+            if (-TM_YEAR_BASE <= t->tm_year
+                && t->tm_year <= 9999 - TM_YEAR_BASE) {
+                n = t->tm_year + TM_YEAR_BASE;
+                if (op->conv != 'y')
+                    pt = _conv_fast(n / 100, op->numfmt, pt, ptlim);
+                if (op->conv != 'C')
+                    pt = _conv_fast(n % 100, op->numfmt, pt, ptlim);
+            } else
+                pt = _yconv(t->tm_year, TM_YEAR_BASE, op->conv != 'y',
+                            op->conv != 'C', pt, ptlim, op->modifier);
+            continue;
+        default:
+            continue;
+        }
+        pt = _conv_fast(n, op->numfmt, pt, ptlim);
+    }
+    return pt;
+}
+#endif
+
 size_t
 strftime(char *restrict s, size_t maxsize, char const *restrict format,
 	 struct tm const *restrict t)
@@ -150,8 +523,20 @@ strftime(char *restrict s, size_t maxsize, char const *restrict format,
     int saved_errno = errno;
     enum warn warn = IN_NONE;
 
+#if defined(__BIONIC__)
+    struct strftime_plan const *plan = plan_get(format);
+    if (plan) {
+        if (plan->uses_zone)
+            tzset();
+        p = plan_exec(plan, t, s, s + maxsize, &warn);
+    } else {
+        tzset();
+        p = _fmt(format, t, s, s + maxsize, &warn);
+    }
+#else
     tzset();
     p = _fmt(format, t, s, s + maxsize, &warn);
+#endif
     if (!p) {
        errno = EOVERFLOW;
        return 0;
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <android-base/file.h>
+
+#if defined(__BIONIC__)
+// Point the cache at a file of our own rather than the system's.
+static const char* hosts_path;
+#undef _PATH_HOSTS
+#define _PATH_HOSTS hosts_path
+#include "../libc/dns/net/hosts_cache.c"
+
+using Lines = std::vector<std::pair<std::string, std::string>>;
+
+// Returns the (address, canonical name) pairs for `name`, in file order, or
+// fails if the cache couldn't index the file.
+static void Lookup(const char* name, Lines* lines) {
+  lines->clear();
+  int n = _hosts_cache_foreach(
+      name,
+      [](const char* addr, const char* cname, void* arg) {
+        static_cast<Lines*>(arg)->emplace_back(addr, cname);
+      },
+      lines);
+  ASSERT_EQ(static_cast<int>(lines->size()), n) << name;
+}
+
+static void WriteHosts(const char* path, const std::string& contents) {
+  ASSERT_TRUE(android::base::WriteStringToFile(contents, path)) << path;
+}
+#endif  // __BIONIC__
+
+TEST(hosts_cache, lookup_by_name) {
+#if defined(__BIONIC__)
+  TemporaryFile file;
+  hosts_path = file.path;
+  WriteHosts(file.path,
+             "# a comment\n"
+             "127.0.0.1\tlocalhost\n"
+             "::1 ip6-localhost # another comment\n"
+             "192.0.2.1  Example.Test  \n"
+             "\n"
+             "   \n"
+             "192.0.2.99\n"
+             "192.0.2.2 last.test");
+
+  Lines lines;
+  ASSERT_NO_FATAL_FAILURE(Lookup("localhost", &lines));
+  EXPECT_EQ((Lines{{"127.0.0.1", "localhost"}}), lines);
+  ASSERT_NO_FATAL_FAILURE(Lookup("ip6-localhost", &lines));
+  EXPECT_EQ((Lines{{"::1", "ip6-localhost"}}), lines);
+
+  // Names are matched without regard to case, and the canonical name is
+  // reported as it appears in the file.
+  ASSERT_NO_FATAL_FAILURE(Lookup("example.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "Example.Test"}}), lines);
+  ASSERT_NO_FATAL_FAILURE(Lookup("EXAMPLE.TEST", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "Example.Test"}}), lines);
+
+  // A last line with no trailing newline still counts.
+  ASSERT_NO_FATAL_FAILURE(Lookup("last.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.2", "last.test"}}), lines);
+
+  // Neither prefixes nor anything in a comment match.
+  ASSERT_NO_FATAL_FAILURE(Lookup("local", &lines));
+  EXPECT_TRUE(lines.empty());
+  ASSERT_NO_FATAL_FAILURE(Lookup("another", &lines));
+  EXPECT_TRUE(lines.empty());
+  ASSERT_NO_FATAL_FAILURE(Lookup("example.test.", &lines));
+  EXPECT_TRUE(lines.empty());
+#else   // __BIONIC__
+  GTEST_SKIP() << "bionic-only test";
+#endif  // __BIONIC__
+}
+
+TEST(hosts_cache, lookup_by_address) {
+#if defined(__BIONIC__)
+  // Only names are indexed (gethostbyaddr still reads the file itself), so
+  // what matters here is that each address comes back exactly as written,
+  // and that an address is never mistaken for a name.
+  TemporaryFile file;
+  hosts_path = file.path;
+  WriteHosts(file.path,
+             "192.0.2.1 v4.test\n"
+             "2001:db8::1 v6.test\n"
+             "fe80::1%lo scoped.test\n"
+             "192.0.2.3 192.0.2.4\n");
+
+  Lines lines;
+  ASSERT_NO_FATAL_FAILURE(Lookup("v4.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "v4.test"}}), lines);
+  ASSERT_NO_FATAL_FAILURE(Lookup("v6.test", &lines));
+  EXPECT_EQ((Lines{{"2001:db8::1", "v6.test"}}), lines);
+  ASSERT_NO_FATAL_FAILURE(Lookup("scoped.test", &lines));
+  EXPECT_EQ((Lines{{"fe80::1%lo", "scoped.test"}}), lines);
+
+  ASSERT_NO_FATAL_FAILURE(Lookup("192.0.2.1", &lines));
+  EXPECT_TRUE(lines.empty());
+  ASSERT_NO_FATAL_FAILURE(Lookup("2001:db8::1", &lines));
+  EXPECT_TRUE(lines.empty());
+  // Something in the name column is a name, however it looks.
+  ASSERT_NO_FATAL_FAILURE(Lookup("192.0.2.4", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.3", "192.0.2.4"}}), lines);
+#else   // __BIONIC__
+  GTEST_SKIP() << "bionic-only test";
+#endif  // __BIONIC__
+}
+
+TEST(hosts_cache, duplicates_and_aliases) {
+#if defined(__BIONIC__)
+  TemporaryFile file;
+  hosts_path = file.path;
+  WriteHosts(file.path,
+             "192.0.2.1 one.test alias.test\n"
+             "192.0.2.2 two.test one.test\n"
+             "2001:db8::1 one.test\n"
+             "192.0.2.3 three.test three.test THREE.TEST\n"
+             "192.0.2.1 one.test\n");
+
+  // Every line that lists a name is reported, in file order, with the first
+  // name on that line as its canonical name.
+  Lines lines;
+  ASSERT_NO_FATAL_FAILURE(Lookup("one.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "one.test"},
+                   {"192.0.2.2", "two.test"},
+                   {"2001:db8::1", "one.test"},
+                   {"192.0.2.1", "one.test"}}),
+            lines);
+  ASSERT_NO_FATAL_FAILURE(Lookup("alias.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "one.test"}}), lines);
+
+  // A name listed more than once on a line only counts once.
+  ASSERT_NO_FATAL_FAILURE(Lookup("three.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.3", "three.test"}}), lines);
+#else   // __BIONIC__
+  GTEST_SKIP() << "bionic-only test";
+#endif  // __BIONIC__
+}
+
+TEST(hosts_cache, rewritten_file) {
+#if defined(__BIONIC__)
+  TemporaryDir dir;
+  std::string path = std::string(dir.path) + "/hosts";
+  hosts_path = path.c_str();
+  WriteHosts(hosts_path, "192.0.2.1 old.test\n");
+
+  Lines lines;
+  ASSERT_NO_FATAL_FAILURE(Lookup("old.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.1", "old.test"}}), lines);
+
+  // Replaced by a new file, the way most editors save.
+  std::string tmp_path = path + ".tmp";
+  WriteHosts(tmp_path.c_str(), "192.0.2.2 new.test\n");
+  ASSERT_EQ(0, rename(tmp_path.c_str(), hosts_path));
+  ASSERT_NO_FATAL_FAILURE(Lookup("old.test", &lines));
+  EXPECT_TRUE(lines.empty());
+  ASSERT_NO_FATAL_FAILURE(Lookup("new.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.2", "new.test"}}), lines);
+
+  // Rewritten in place with contents of the same size, so that only the
+  // modification time gives it away. Set that explicitly in case the
+  // clock hasn't ticked since the last write.
+  WriteHosts(hosts_path, "192.0.2.3 now.test\n");
+  timespec times[2] = {{.tv_sec = 0, .tv_nsec = UTIME_OMIT}, {.tv_sec = 1234, .tv_nsec = 0}};
+  ASSERT_EQ(0, utimensat(AT_FDCWD, hosts_path, times, 0));
+  ASSERT_NO_FATAL_FAILURE(Lookup("new.test", &lines));
+  EXPECT_TRUE(lines.empty());
+  ASSERT_NO_FATAL_FAILURE(Lookup("now.test", &lines));
+  EXPECT_EQ((Lines{{"192.0.2.3", "now.test"}}), lines);
+
+  // A file that can't be indexed leaves it to the caller.
+  WriteHosts(hosts_path, "");
+  EXPECT_EQ(-1, _hosts_cache_foreach("now.test", [](const char*, const char*, void*) {}, nullptr));
+  ASSERT_EQ(0, unlink(hosts_path));
+  EXPECT_EQ(-1, _hosts_cache_foreach("now.test", [](const char*, const char*, void*) {}, nullptr));
+#else   // __BIONIC__
+  GTEST_SKIP() << "bionic-only test";
+#endif  // __BIONIC__
+}
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <dirent.h>
 #include <elf.h>
 #include <limits.h>
 #include <malloc.h>
@@ -36,6 +37,7 @@
 #include <algorithm>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -45,6 +47,7 @@
 #include <tinyxml2.h>
 
 #include <android-base/file.h>
+#include <android-base/strings.h>
 #include <android-base/test_utils.h>
 
 #include "utils.h"
@@ -1768,3 +1771,170 @@ TEST(android_mallopt, get_decay_time_enabled) {
   GTEST_SKIP() << "bionic-only test";
 #endif
 }
+
+TEST(android_mallopt, set_background_purge_target_errors) {
+#if defined(__BIONIC__)
+  errno = 0;
+  EXPECT_FALSE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, nullptr, sizeof(size_t)));
+  EXPECT_ERRNO(EINVAL);
+
+  errno = 0;
+  int value = 0;
+  EXPECT_FALSE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &value, sizeof(value)));
+  EXPECT_ERRNO(EINVAL);
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+#if defined(__BIONIC__)
+// Returns how many of this process' threads are called `name`.
+static size_t CountThreadsNamed(const char* name) {
+  size_t count = 0;
+  std::unique_ptr<DIR, decltype(&closedir)> dir(opendir("/proc/self/task"), closedir);
+  if (dir == nullptr) return 0;
+  while (dirent* de = readdir(dir.get())) {
+    if (de->d_name[0] == '.') continue;
+    std::string comm;
+    if (android::base::ReadFileToString(std::string("/proc/self/task/") + de->d_name + "/comm",
+                                        &comm) &&
+        android::base::Trim(comm) == name) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// Waits up to five seconds for there to be `expected` threads called `name`.
+static bool WaitForThreadsNamed(const char* name, size_t expected) {
+  for (size_t i = 0; i < 500; ++i) {
+    if (CountThreadsNamed(name) == expected) return true;
+    usleep(10 * 1000);
+  }
+  return false;
+}
+#endif
+
+TEST(android_mallopt, set_background_purge_target) {
+#if defined(__BIONIC__)
+  SKIP_WITH_HWASAN << "hwasan does not implement mallopt";
+
+  // Whether a purge actually releases memory is checked by the test below;
+  // this one watches the purge thread itself.
+  ASSERT_EQ(0U, CountThreadsNamed("mallocpurge"));
+
+  size_t target = 0;
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+  ASSERT_TRUE(WaitForThreadsNamed("mallocpurge", 1));
+
+  // Reconfiguring a running purge thread is allowed, and doesn't start
+  // another one.
+  target = 1024 * 1024;
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+
+  // Give the thread a chance to run with a heap it should purge.
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < 1024; i++) {
+    ptrs.push_back(malloc(4096));
+  }
+  for (void* ptr : ptrs) {
+    free(ptr);
+  }
+  sleep(2);
+  ASSERT_EQ(1U, CountThreadsNamed("mallocpurge"));
+
+  // A forked child doesn't inherit the thread, and can start and stop its own.
+  pid_t pid;
+  if ((pid = fork()) == 0) {
+    size_t child_target = 0;
+    if (CountThreadsNamed("mallocpurge") != 0) _exit(1);
+    if (!android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &child_target, sizeof(child_target))) {
+      _exit(2);
+    }
+    if (!WaitForThreadsNamed("mallocpurge", 1)) _exit(3);
+    child_target = SIZE_MAX;
+    if (!android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &child_target, sizeof(child_target))) {
+      _exit(4);
+    }
+    if (!WaitForThreadsNamed("mallocpurge", 0)) _exit(5);
+    _exit(0);
+  }
+  ASSERT_NE(-1, pid);
+  AssertChildExited(pid, 0);
+
+  target = SIZE_MAX;
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+  ASSERT_TRUE(WaitForThreadsNamed("mallocpurge", 0));
+  // Stopping an already stopped thread is not an error.
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+  ASSERT_EQ(0U, CountThreadsNamed("mallocpurge"));
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+#if defined(__BIONIC__)
+// Returns this process' resident set size in bytes, or 0 on error.
+static size_t GetRssBytes() {
+  std::string statm;
+  if (!android::base::ReadFileToString("/proc/self/statm", &statm)) return 0;
+  std::vector<std::string> fields = android::base::Split(statm, " ");
+  if (fields.size() < 2) return 0;
+  return strtoull(fields[1].c_str(), nullptr, 10) * getpagesize();
+}
+#endif
+
+TEST(android_mallopt, set_background_purge_target_releases_memory) {
+#if defined(__BIONIC__)
+  SKIP_WITH_HWASAN << "hwasan does not implement mallopt";
+
+  // Keep freed memory resident until something purges it, as in an app.
+  bool decay_time_enabled;
+  ASSERT_TRUE(android_mallopt(M_GET_DECAY_TIME_ENABLED, &decay_time_enabled,
+                              sizeof(decay_time_enabled)));
+  ASSERT_EQ(1, mallopt(M_DECAY_TIME, 1));
+
+  // Allocations this big bypass the per-thread caches, which only their own
+  // thread can flush.
+  constexpr size_t kAllocationSize = 1024 * 1024;
+  constexpr size_t kAllocationCount = 32;
+  constexpr size_t kFreedBytes = kAllocationSize * kAllocationCount;
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < kAllocationCount; i++) {
+    void* ptr = malloc(kAllocationSize);
+    ASSERT_TRUE(ptr != nullptr);
+    memset(ptr, 1, kAllocationSize);
+    ptrs.push_back(ptr);
+  }
+  size_t rss_in_use = GetRssBytes();
+  for (void* ptr : ptrs) {
+    free(ptr);
+  }
+  size_t rss_freed = GetRssBytes();
+  ASSERT_NE(0U, rss_freed);
+  if (rss_freed + kFreedBytes / 2 < rss_in_use) {
+    mallopt(M_DECAY_TIME, decay_time_enabled);
+    GTEST_SKIP() << "the allocator released the memory as soon as it was freed";
+  }
+
+  // The thread purges once a sample finds the heap idle, which should take
+  // a couple of seconds. Allow plenty more.
+  size_t target = 0;
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+  size_t rss_purged = rss_freed;
+  for (size_t i = 0; i < 100 && rss_purged + kFreedBytes / 2 > rss_freed; ++i) {
+    usleep(100 * 1000);
+    rss_purged = GetRssBytes();
+  }
+  target = SIZE_MAX;
+  ASSERT_TRUE(android_mallopt(M_SET_BACKGROUND_PURGE_TARGET, &target, sizeof(target)));
+  ASSERT_TRUE(WaitForThreadsNamed("mallocpurge", 0));
+  mallopt(M_DECAY_TIME, decay_time_enabled);
+
+  // At least half of what was freed went back to the kernel.
+  EXPECT_LE(rss_purged + kFreedBytes / 2, rss_freed)
+      << "rss after free: " << rss_freed << ", after purge: " << rss_purged;
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
@@ -19,11 +19,23 @@
 #include <gtest/gtest.h>
 
 #include <arpa/inet.h>
+#include <arpa/nameser.h>
+#include <errno.h>
 #include <netinet/in.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/cdefs.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#if defined(__BIONIC__)
+#include "dns/include/resolv_netid.h"
+#endif
 
 // https://code.google.com/p/android/issues/detail?id=13228
 TEST(netdb, freeaddrinfo_NULL) {
@@ -492,3 +504,283 @@ TEST(netdb, sethostent_resets) {
   sethostent(0);
   ASSERT_EQ(first_host, std::string(gethostent()->h_name));
 }
+
+#if defined(__BIONIC__)
+
+// A DNS server on 127.0.0.1:53 that's the only nameserver of a network of
+// its own, so tests can see exactly what the resolver sends. Port 53 needs
+// root, so Start() fails without it.
+class FakeDnsServer {
+ public:
+  enum Reply { kAnswer, kServFail };
+
+  static constexpr unsigned kNetId = 6502;
+
+  ~FakeDnsServer() { Stop(); }
+
+  bool Start(int stale_ttl_sec = 0) {
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ == -1) return false;
+    sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(53)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval tv = {.tv_sec = 0, .tv_usec = 100 * 1000};
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+
+    // Only processes that do their own DNS (like netd) use the cache.
+    setenv("ANDROID_DNS_MODE", "local", 1);
+    _resolv_delete_cache_for_net(kNetId);
+    const char* servers[] = {"127.0.0.1"};
+    __res_params params = {};
+    params.sample_validity = NSSAMPLE_VALIDITY;
+    params.success_threshold = SUCCESS_THRESHOLD;
+    params.stale_ttl_sec = stale_ttl_sec;
+    if (_resolv_set_nameservers_for_net(kNetId, servers, 1, "", &params) != 0) return false;
+
+    thread_ = std::thread([this] { Serve(); });
+    return true;
+  }
+
+  void Stop() {
+    if (fd_ == -1) return;
+    stop_ = true;
+    thread_.join();
+    close(fd_);
+    fd_ = -1;
+    _resolv_delete_cache_for_net(kNetId);
+    unsetenv("ANDROID_DNS_MODE");
+  }
+
+  int Queries(int qtype) { return (qtype == ns_t_aaaa) ? aaaa_queries_ : a_queries_; }
+
+  // Waits up to five seconds for there to have been `n` queries of type `qtype`.
+  bool WaitForQueries(int qtype, int n) {
+    for (size_t i = 0; i < 500; ++i) {
+      if (Queries(qtype) >= n) return true;
+      usleep(10 * 1000);
+    }
+    return false;
+  }
+
+  std::atomic<Reply> a_reply{kAnswer};
+  std::atomic<Reply> aaaa_reply{kAnswer};
+  // The A answer is 192.0.2.`a_host`.
+  std::atomic<uint8_t> a_host{1};
+  std::atomic<uint8_t> ttl{60};
+  // How long to sit on each query before replying.
+  std::atomic<int> delay_ms{0};
+
+ private:
+  void Serve() {
+    while (!stop_) {
+      uint8_t buf[512];
+      sockaddr_storage from;
+      socklen_t from_len = sizeof(from);
+      ssize_t n = recvfrom(fd_, buf, sizeof(buf) - 64, 0, reinterpret_cast<sockaddr*>(&from),
+                           &from_len);
+      if (n < HFIXEDSZ) continue;
+
+      // Find the type at the end of the question.
+      size_t len = HFIXEDSZ;
+      while (len < static_cast<size_t>(n) && buf[len] != 0) len += buf[len] + 1;
+      if (len + 5 > static_cast<size_t>(n)) continue;
+      int qtype = (buf[len + 1] << 8) | buf[len + 2];
+      len += 5;
+      if (qtype == ns_t_aaaa) {
+        ++aaaa_queries_;
+      } else if (qtype == ns_t_a) {
+        ++a_queries_;
+      }
+
+      // Reply with the question, and an answer if we have one.
+      Reply reply = (qtype == ns_t_aaaa) ? aaaa_reply.load() : a_reply.load();
+      if (delay_ms > 0) usleep(delay_ms * 1000);
+      HEADER* hp = reinterpret_cast<HEADER*>(buf);
+      hp->qr = 1;
+      hp->aa = 1;
+      hp->ra = 1;
+      hp->rcode = (reply == kServFail) ? SERVFAIL : NOERROR;
+      hp->ancount = 0;
+      hp->nscount = 0;
+      hp->arcount = 0;
+      if (reply == kAnswer && (qtype == ns_t_a || qtype == ns_t_aaaa)) {
+        const uint8_t v4[] = {192, 0, 2, a_host};
+        const uint8_t v6[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+        const uint8_t* rdata = (qtype == ns_t_a) ? v4 : v6;
+        size_t rdlength = (qtype == ns_t_a) ? sizeof(v4) : sizeof(v6);
+        const uint8_t rr[] = {0xc0, HFIXEDSZ,  // The name in the question.
+                              0, static_cast<uint8_t>(qtype), 0, ns_c_in,
+                              0, 0, 0, ttl,  // TTL.
+                              0, static_cast<uint8_t>(rdlength)};
+        memcpy(buf + len, rr, sizeof(rr));
+        memcpy(buf + len + sizeof(rr), rdata, rdlength);
+        len += sizeof(rr) + rdlength;
+        hp->ancount = htons(1);
+      }
+      sendto(fd_, buf, len, 0, reinterpret_cast<sockaddr*>(&from), from_len);
+    }
+  }
+
+  int fd_ = -1;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<int> a_queries_{0};
+  std::atomic<int> aaaa_queries_{0};
+};
+
+static void GetAddrInfoOnFakeDns(const char* name, bool* have_v4, bool* have_v6) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* ai = nullptr;
+  *have_v4 = *have_v6 = false;
+  ASSERT_EQ(0, android_getaddrinfofornet(name, nullptr, &hints, FakeDnsServer::kNetId, MARK_UNSET,
+                                         &ai));
+  for (addrinfo* p = ai; p != nullptr; p = p->ai_next) {
+    if (p->ai_family == AF_INET) *have_v4 = true;
+    if (p->ai_family == AF_INET6) *have_v6 = true;
+  }
+  freeaddrinfo(ai);
+}
+
+// Returns the last byte of the IPv4 address `name` resolves to, or -1.
+static int GetIPv4HostOnFakeDns(const char* name) {
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* ai = nullptr;
+  if (android_getaddrinfofornet(name, nullptr, &hints, FakeDnsServer::kNetId, MARK_UNSET, &ai) !=
+      0) {
+    return -1;
+  }
+  int host = ntohl(reinterpret_cast<sockaddr_in*>(ai->ai_addr)->sin_addr.s_addr) & 0xff;
+  freeaddrinfo(ai);
+  return host;
+}
+
+// Returns the wall clock time, which the cache counts in whole seconds, in ms.
+static int64_t NowMs() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+}
+
+static void SleepUntilMs(int64_t ms) {
+  int64_t now = NowMs();
+  if (ms > now) usleep((ms - now) * 1000);
+}
+
+#endif
+
+TEST(netdb, getaddrinfo_AF_UNSPEC_sends_A_and_AAAA_together) {
+#if defined(__BIONIC__)
+  FakeDnsServer dns;
+  if (!dns.Start()) GTEST_SKIP() << "couldn't run a DNS server on 127.0.0.1:53";
+
+  bool have_v4, have_v6;
+  ASSERT_NO_FATAL_FAILURE(GetAddrInfoOnFakeDns("pair.test", &have_v4, &have_v6));
+  EXPECT_TRUE(have_v4);
+  EXPECT_TRUE(have_v6);
+  // One of each, sent once: no retries, and nothing sent again one at a time.
+  EXPECT_EQ(1, dns.Queries(ns_t_a));
+  EXPECT_EQ(1, dns.Queries(ns_t_aaaa));
+
+  // Both answers were cached.
+  ASSERT_NO_FATAL_FAILURE(GetAddrInfoOnFakeDns("pair.test", &have_v4, &have_v6));
+  EXPECT_TRUE(have_v4);
+  EXPECT_TRUE(have_v6);
+  EXPECT_EQ(1, dns.Queries(ns_t_a));
+  EXPECT_EQ(1, dns.Queries(ns_t_aaaa));
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(netdb, getaddrinfo_AF_UNSPEC_one_query_fails) {
+#if defined(__BIONIC__)
+  FakeDnsServer dns;
+  if (!dns.Start()) GTEST_SKIP() << "couldn't run a DNS server on 127.0.0.1:53";
+  dns.aaaa_reply = FakeDnsServer::kServFail;
+
+  // The A answer arrives with the pair, and the AAAA query goes the slow
+  // way, which retries it before giving up.
+  bool have_v4, have_v6;
+  ASSERT_NO_FATAL_FAILURE(GetAddrInfoOnFakeDns("half.test", &have_v4, &have_v6));
+  EXPECT_TRUE(have_v4);
+  EXPECT_FALSE(have_v6);
+  EXPECT_EQ(1, dns.Queries(ns_t_a));
+  EXPECT_GT(dns.Queries(ns_t_aaaa), 1);
+
+  // The A answer was cached even though the AAAA query failed.
+  dns.aaaa_reply = FakeDnsServer::kAnswer;
+  ASSERT_NO_FATAL_FAILURE(GetAddrInfoOnFakeDns("half.test", &have_v4, &have_v6));
+  EXPECT_TRUE(have_v4);
+  EXPECT_TRUE(have_v6);
+  EXPECT_EQ(1, dns.Queries(ns_t_a));
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(netdb, resolv_set_nameservers_rejects_negative_stale_ttl) {
+#if defined(__BIONIC__)
+  const char* servers[] = {"127.0.0.1"};
+  __res_params params = {};
+  params.stale_ttl_sec = -1;
+  EXPECT_EQ(EINVAL,
+            _resolv_set_nameservers_for_net(FakeDnsServer::kNetId, servers, 1, "", &params));
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(netdb, getaddrinfo_serves_stale_answers) {
+#if defined(__BIONIC__)
+  FakeDnsServer dns;
+  if (!dns.Start(1)) GTEST_SKIP() << "couldn't run a DNS server on 127.0.0.1:53";
+  dns.ttl = 1;
+
+  // Cache two answers just after a second starts, so that they expire when
+  // the next one starts, and are dropped at the start of the one after that.
+  int64_t start_ms = (NowMs() / 1000 + 1) * 1000;
+  SleepUntilMs(start_ms + 50);
+  ASSERT_EQ(1, GetIPv4HostOnFakeDns("stale.test"));
+  ASSERT_EQ(1, GetIPv4HostOnFakeDns("dropped.test"));
+  ASSERT_EQ(2, dns.Queries(ns_t_a));
+  ASSERT_LT(NowMs(), start_ms + 1000) << "caching the answers took too long";
+
+  // Once an answer has expired, the first lookup refreshes it. While that's
+  // still going on, other lookups get the expired answer straight away.
+  SleepUntilMs(start_ms + 1100);
+  dns.a_host = 2;
+  dns.delay_ms = 300;
+  int refreshed = -1;
+  std::thread refresher([&refreshed] { refreshed = GetIPv4HostOnFakeDns("stale.test"); });
+  bool refreshing = dns.WaitForQueries(ns_t_a, 3);
+  int during_refresh = refreshing ? GetIPv4HostOnFakeDns("stale.test") : -1;
+  refresher.join();
+  ASSERT_TRUE(refreshing) << "the expired answer was never refreshed";
+  EXPECT_EQ(1, during_refresh);
+  EXPECT_EQ(2, refreshed);
+  EXPECT_EQ(3, dns.Queries(ns_t_a));
+
+  // Past stale_ttl_sec, an answer is dropped, so a lookup during the refresh
+  // waits for it instead.
+  SleepUntilMs(start_ms + 2100);
+  dns.a_host = 3;
+  refresher = std::thread([&refreshed] { refreshed = GetIPv4HostOnFakeDns("dropped.test"); });
+  refreshing = dns.WaitForQueries(ns_t_a, 4);
+  during_refresh = refreshing ? GetIPv4HostOnFakeDns("dropped.test") : -1;
+  refresher.join();
+  ASSERT_TRUE(refreshing) << "the dropped answer was never looked up again";
+  EXPECT_EQ(3, during_refresh);
+  EXPECT_EQ(3, refreshed);
+  EXPECT_EQ(4, dns.Queries(ns_t_a));
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
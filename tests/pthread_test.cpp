@@ -35,6 +35,7 @@
 
 #include <atomic>
 #include <future>
+#include <thread>
 #include <vector>
 
 #include <android-base/macros.h>
@@ -2072,6 +2073,12 @@ TEST(pthread, pthread_mutexattr_gettype) {
   ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
   ASSERT_EQ(PTHREAD_MUTEX_RECURSIVE, attr_type);
 
+#if !defined(ANDROID_HOST_MUSL)
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP));
+  ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
+  ASSERT_EQ(PTHREAD_MUTEX_ADAPTIVE_NP, attr_type);
+#endif
+
   ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
 }
 
@@ -2131,8 +2138,8 @@ static int UnlockFromAnotherThread(pthread_mutex_t* mutex) {
   return reinterpret_cast<intptr_t>(result);
 };
 
-static void TestPthreadMutexLockNormal(int protocol) {
-  PthreadMutex m(PTHREAD_MUTEX_NORMAL, protocol);
+static void TestPthreadMutexLockNormal(int protocol, int mutex_type = PTHREAD_MUTEX_NORMAL) {
+  PthreadMutex m(mutex_type, protocol);
 
   ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
   if (protocol == PTHREAD_PRIO_INHERIT) {
@@ -2189,10 +2196,19 @@ TEST(pthread, pthread_mutex_lock_RECURSIVE) {
   TestPthreadMutexLockRecursive(PTHREAD_PRIO_NONE);
 }
 
+#if !defined(ANDROID_HOST_MUSL)
+TEST(pthread, pthread_mutex_lock_ADAPTIVE) {
+  TestPthreadMutexLockNormal(PTHREAD_PRIO_NONE, PTHREAD_MUTEX_ADAPTIVE_NP);
+}
+#endif
+
 TEST(pthread, pthread_mutex_lock_pi) {
   TestPthreadMutexLockNormal(PTHREAD_PRIO_INHERIT);
   TestPthreadMutexLockErrorCheck(PTHREAD_PRIO_INHERIT);
   TestPthreadMutexLockRecursive(PTHREAD_PRIO_INHERIT);
+#if !defined(ANDROID_HOST_MUSL)
+  TestPthreadMutexLockNormal(PTHREAD_PRIO_INHERIT, PTHREAD_MUTEX_ADAPTIVE_NP);
+#endif
 }
 
 TEST(pthread, pthread_mutex_pi_count_limit) {
@@ -2244,6 +2260,11 @@ TEST(pthread, pthread_mutex_init_same_as_static_initializers) {
   PthreadMutex m3(PTHREAD_MUTEX_RECURSIVE);
   ASSERT_EQ(0, memcmp(&lock_recursive, &m3.lock, sizeof(pthread_mutex_t)));
   ASSERT_EQ(0, pthread_mutex_destroy(&lock_recursive));
+
+  pthread_mutex_t lock_adaptive = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  PthreadMutex m4(PTHREAD_MUTEX_ADAPTIVE_NP);
+  ASSERT_EQ(0, memcmp(&lock_adaptive, &m4.lock, sizeof(pthread_mutex_t)));
+  ASSERT_EQ(0, pthread_mutex_destroy(&lock_adaptive));
 #endif
 }
 
@@ -2310,6 +2331,36 @@ TEST(pthread, pthread_mutex_RECURSIVE_wakeup) {
   helper.test();
 }
 
+#if !defined(ANDROID_HOST_MUSL)
+TEST(pthread, pthread_mutex_ADAPTIVE_wakeup) {
+  MutexWakeupHelper helper(PTHREAD_MUTEX_ADAPTIVE_NP);
+  helper.test();
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_contention) {
+  // Short critical sections from several threads, so lock calls both win while
+  // spinning and give up and sleep.
+  PthreadMutex m(PTHREAD_MUTEX_ADAPTIVE_NP);
+  constexpr int kThreadCount = 4;
+  constexpr int kIterations = 20000;
+  int counter = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < kIterations; ++j) {
+        ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+        ++counter;
+        ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(kThreadCount * kIterations, counter);
+}
+#endif
+
 static int GetThreadPriority(pid_t tid) {
   // sched_getparam() returns the static priority of a thread, which can't reflect a thread's
   // priority after priority inheritance. So read /proc/<pid>/stat to get the dynamic priority.
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <sched.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -310,3 +311,22 @@ TEST(sched, sched_getaffinity_failure) {
   ASSERT_EQ(-1, sched_getaffinity(getpid(), 0, nullptr));
 #pragma clang diagnostic pop
 }
+
+TEST(sched, sched_getcpu) {
+  // Pin ourselves to each CPU we're allowed to run on in turn, and check
+  // that sched_getcpu (which may use the vdso) agrees with the system call.
+  cpu_set_t original_set;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original_set), &original_set));
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &original_set)) continue;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(set), &set));
+    EXPECT_EQ(cpu, sched_getcpu());
+    unsigned syscall_cpu;
+    ASSERT_EQ(0, syscall(__NR_getcpu, &syscall_cpu, nullptr, nullptr));
+    EXPECT_EQ(static_cast<unsigned>(cpu), syscall_cpu);
+  }
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original_set), &original_set));
+}
@@ -30,6 +30,7 @@
 #include <unistd.h>
 #include <wchar.h>
 
+#include <atomic>
 #include <string>
 #include <thread>
 #include <vector>
@@ -137,6 +138,57 @@ TEST(STDIO_TEST, flockfile_18208568_regular) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, flockfile_blocks_other_threads) {
+  // stdio may skip FILE locks while there's only one thread, but it has to
+  // start respecting them as soon as a second thread exists.
+  FILE* fp = fopen("/dev/null", "w");
+  ASSERT_TRUE(fp != nullptr);
+  flockfile(fp);
+  ASSERT_EQ('a', fputc('a', fp));
+
+  std::atomic<pid_t> tid(0);
+  std::atomic<bool> done(false);
+  std::thread t([&] {
+    tid = gettid();
+    fputc('b', fp);
+    done = true;
+  });
+  WaitUntilThreadSleep(tid);
+  ASSERT_FALSE(done);
+
+  funlockfile(fp);
+  t.join();
+  ASSERT_TRUE(done);
+  fclose(fp);
+}
+
+TEST(STDIO_TEST, flockfile_survives_thread_created_by_callback) {
+  // stdio may skip its own locking while there's only one thread, but a write
+  // callback that creates the first thread mustn't make stdio release the
+  // hold we took with flockfile().
+  auto write_fn = [](void*, const char*, int n) {
+    std::thread([] {}).join();
+    return n;
+  };
+  FILE* fp = funopen(nullptr, nullptr, write_fn, nullptr, nullptr);
+  ASSERT_TRUE(fp != nullptr);
+  flockfile(fp);
+  ASSERT_EQ('a', fputc('a', fp));
+  ASSERT_EQ(0, fflush(fp));
+
+  int rc = 0;
+  std::thread([&] { rc = ftrylockfile(fp); }).join();
+  ASSERT_NE(0, rc);
+
+  funlockfile(fp);
+  std::thread([&] {
+    rc = ftrylockfile(fp);
+    if (rc == 0) funlockfile(fp);
+  }).join();
+  ASSERT_EQ(0, rc);
+  fclose(fp);
+}
+
 TEST(STDIO_TEST, tmpfile_fileno_fprintf_rewind_fgets) {
   FILE* fp = tmpfile();
   ASSERT_TRUE(fp != nullptr);
@@ -300,6 +352,66 @@ TEST(STDIO_TEST, getline) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, getline_long_lines) {
+  // Lines longer than the FILE's buffer need several refills and several
+  // rounds of growing the caller's buffer.
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+
+  std::string short_line(10, 'a');
+  std::string long_line(3 * BUFSIZ + 17, 'b');
+  ASSERT_EQ(0, fputs((short_line + "\n" + long_line + "\n" + short_line).c_str(), fp));
+  rewind(fp);
+
+  char* line_read = nullptr;
+  size_t allocated_length = 0;
+  ASSERT_EQ(static_cast<ssize_t>(short_line.size() + 1), getline(&line_read, &allocated_length, fp));
+  ASSERT_EQ(short_line + "\n", line_read);
+  ASSERT_EQ(static_cast<ssize_t>(long_line.size() + 1), getline(&line_read, &allocated_length, fp));
+  ASSERT_EQ(long_line + "\n", line_read);
+  ASSERT_GT(allocated_length, long_line.size() + 1);
+  ASSERT_EQ(static_cast<ssize_t>(short_line.size()), getline(&line_read, &allocated_length, fp));
+  ASSERT_EQ(short_line, line_read);
+  ASSERT_EQ(-1, getline(&line_read, &allocated_length, fp));
+
+  free(line_read);
+  fclose(fp);
+}
+
+TEST(STDIO_TEST, fgetln) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+
+  std::string long_line(3 * BUFSIZ + 17, 'b');
+  ASSERT_EQ(0, fputs(("hello\n" + long_line + "\n" + "world").c_str(), fp));
+  rewind(fp);
+
+  // A line that fits in the FILE's buffer...
+  size_t length;
+  char* line = fgetln(fp, &length);
+  ASSERT_TRUE(line != nullptr);
+  ASSERT_EQ("hello\n", std::string(line, length));
+
+  // ...a line that doesn't...
+  line = fgetln(fp, &length);
+  ASSERT_TRUE(line != nullptr);
+  ASSERT_EQ(long_line + "\n", std::string(line, length));
+
+  // ...and a final line with no newline.
+  line = fgetln(fp, &length);
+  ASSERT_TRUE(line != nullptr);
+  ASSERT_EQ("world", std::string(line, length));
+
+  ASSERT_TRUE(fgetln(fp, &length) == nullptr);
+  ASSERT_EQ(0U, length);
+  ASSERT_TRUE(feof(fp));
+  fclose(fp);
+#else
+  GTEST_SKIP() << "glibc doesn't have fgetln";
+#endif
+}
+
 TEST(STDIO_TEST, getline_invalid) {
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnonnull"
@@ -829,6 +941,21 @@ TEST(STDIO_TEST, swprintf_X_UINT_MAX) {
   EXPECT_SWPRINTF(L"FFFFFFFF", L"%X", UINT_MAX);
 }
 
+TEST(STDIO_TEST, snprintf_simple_conversions) {
+  // These only use conversions that snprintf() formats without a FILE.
+  char buf[BUFSIZ];
+  EXPECT_EQ(53, snprintf(buf, sizeof(buf), "%d %i %u %x %X %c %s %% %zu %zd %ld %lld %jd %td",
+                         -1, 23, 45u, 0xabu, 0xcdu, 'z', "str", static_cast<size_t>(99),
+                         static_cast<ssize_t>(-99), -100L, 1000000000000LL,
+                         static_cast<intmax_t>(-7), static_cast<ptrdiff_t>(8)));
+  EXPECT_STREQ("-1 23 45 ab CD z str % 99 -99 -100 1000000000000 -7 8", buf);
+
+  // Truncation still reports the full length.
+  EXPECT_EQ(10, snprintf(buf, 5, "%d%s", 12345, "abcde"));
+  EXPECT_STREQ("1234", buf);
+  EXPECT_EQ(3, snprintf(nullptr, 0, "%s", "abc"));
+}
+
 TEST(STDIO_TEST, snprintf_e) {
   EXPECT_SNPRINTF("1.500000e+00", "%e", 1.5);
   EXPECT_SNPRINTF("1.500000e+00", "%Le", 1.5L);
@@ -2916,6 +3043,144 @@ TEST(STDIO_TEST, freopen_invalid_mode) {
   ASSERT_ERRNO(EINVAL);
 }
 
+TEST(STDIO_TEST, fopen_mmap_mode) {
+  TemporaryFile tf;
+  std::string contents = "hello\nworld\n" + std::string(2 * BUFSIZ, 'x') + "\nend";
+  ASSERT_TRUE(android::base::WriteStringToFd(contents, tf.fd));
+
+  FILE* fp = fopen(tf.path, "rme");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, ftell(fp));
+
+  char line[16];
+  ASSERT_STREQ("hello\n", fgets(line, sizeof(line), fp));
+  ASSERT_EQ(6, ftell(fp));
+  ASSERT_EQ('w', getc(fp));
+  ASSERT_EQ('w', ungetc('w', fp));
+  ASSERT_EQ('W', ungetc('W', fp));
+  ASSERT_EQ('W', getc(fp));
+  ASSERT_STREQ("world\n", fgets(line, sizeof(line), fp));
+
+  // Seeking, including backwards, reads the same data again.
+  ASSERT_EQ(0, fseek(fp, -3, SEEK_END));
+  ASSERT_STREQ("end", fgets(line, sizeof(line), fp));
+  ASSERT_TRUE(fgets(line, sizeof(line), fp) == nullptr);
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(static_cast<long>(contents.size()), ftell(fp));
+
+  rewind(fp);
+  std::string all(contents.size(), '\0');
+  ASSERT_EQ(contents.size(), fread(&all[0], 1, all.size(), fp));
+  ASSERT_EQ(contents, all);
+  ASSERT_EQ(EOF, getc(fp));
+
+  // Seeking past the end is fine, but there's nothing to read there.
+  ASSERT_EQ(0, fseek(fp, contents.size() + 10, SEEK_SET));
+  ASSERT_EQ(static_cast<long>(contents.size() + 10), ftell(fp));
+  ASSERT_EQ(EOF, getc(fp));
+
+  // The stream is read-only.
+  ASSERT_EQ(EOF, fputc('x', fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_mmap_mode_fallback) {
+  // Files that can't be mapped just use normal buffering.
+  FILE* fp = fopen("/proc/version", "rm");
+  ASSERT_TRUE(fp != nullptr);
+  char buf[16];
+  ASSERT_TRUE(fgets(buf, sizeof(buf), fp) != nullptr);
+  ASSERT_EQ(0, strncmp("Linux version ", buf, 14));
+  fclose(fp);
+
+  TemporaryDir td;
+  std::string fifo_path = std::string(td.path) + "/fifo";
+  ASSERT_EQ(0, mkfifo(fifo_path.c_str(), 0600));
+  // Holding a write end open means opening the read end won't block.
+  android::base::unique_fd writer(open(fifo_path.c_str(), O_RDWR | O_CLOEXEC));
+  ASSERT_NE(-1, writer.get());
+  ASSERT_EQ(5, write(writer.get(), "pipe\n", 5));
+  fp = fopen(fifo_path.c_str(), "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_STREQ("pipe\n", fgets(buf, sizeof(buf), fp));
+  fclose(fp);
+  ASSERT_EQ(0, unlink(fifo_path.c_str()));
+}
+
+#if defined(__BIONIC__)
+// Returns true if `path` is mapped into this process.
+static bool IsMapped(const char* path) {
+  std::string maps;
+  return android::base::ReadFileToString("/proc/self/maps", &maps) &&
+         maps.find(std::string(" ") + path + "\n") != std::string::npos;
+}
+#endif
+
+TEST(STDIO_TEST, fopen_mmap_mode_eof_and_seeks) {
+  TemporaryFile tf;
+  std::string contents;
+  for (size_t i = 0; i < 3 * BUFSIZ; ++i) contents += static_cast<char>('a' + i % 26);
+  ASSERT_TRUE(android::base::WriteStringToFd(contents, tf.fd));
+
+  FILE* fp = fopen(tf.path, "rm");
+  ASSERT_TRUE(fp != nullptr);
+#if defined(__BIONIC__)
+  // The file was mapped rather than read.
+  ASSERT_TRUE(IsMapped(tf.path));
+#endif
+
+  // Read everything a character at a time, then keep reading past the end.
+  for (size_t i = 0; i < contents.size(); ++i) ASSERT_EQ(contents[i], getc(fp)) << i;
+  ASSERT_FALSE(feof(fp));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(EOF, getc(fp));
+  char buf[64];
+  ASSERT_EQ(0U, fread(buf, 1, sizeof(buf), fp));
+  ASSERT_TRUE(fgets(buf, sizeof(buf), fp) == nullptr);
+  clearerr(fp);
+  ASSERT_FALSE(feof(fp));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_FALSE(ferror(fp));
+  ASSERT_EQ(static_cast<long>(contents.size()), ftell(fp));
+
+  // Every kind of seek works from EOF, and clears it.
+  ASSERT_EQ(0, fseek(fp, BUFSIZ + 1, SEEK_SET));
+  ASSERT_FALSE(feof(fp));
+  ASSERT_EQ(BUFSIZ + 1, ftell(fp));
+  ASSERT_EQ(contents[BUFSIZ + 1], getc(fp));
+  ASSERT_EQ(0, fseek(fp, -10, SEEK_CUR));
+  ASSERT_EQ(BUFSIZ + 2 - 10, ftell(fp));
+  ASSERT_EQ(contents[BUFSIZ + 2 - 10], getc(fp));
+  ASSERT_EQ(0, fseek(fp, BUFSIZ, SEEK_CUR));
+  ASSERT_EQ(contents[2 * BUFSIZ + 3 - 10], getc(fp));
+  ASSERT_EQ(0, fseek(fp, -1, SEEK_END));
+  ASSERT_EQ(contents.back(), getc(fp));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_EQ(0, fseek(fp, 0, SEEK_END));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_EQ(-1, fseek(fp, -1, SEEK_SET));
+  ASSERT_EQ(static_cast<long>(contents.size()), ftell(fp));
+
+  // A big fread from the middle matches, and stops at the end.
+  ASSERT_EQ(0, fseek(fp, 7, SEEK_SET));
+  std::string rest(contents.size(), '\0');
+  ASSERT_EQ(contents.size() - 7, fread(&rest[0], 1, rest.size(), fp));
+  rest.resize(contents.size() - 7);
+  ASSERT_EQ(contents.substr(7), rest);
+  ASSERT_TRUE(feof(fp));
+
+  rewind(fp);
+  ASSERT_FALSE(feof(fp));
+  ASSERT_EQ(contents[0], getc(fp));
+
+  ASSERT_EQ(0, fclose(fp));
+#if defined(__BIONIC__)
+  ASSERT_FALSE(IsMapped(tf.path));
+#endif
+}
+
 TEST(STDIO_TEST, asprintf_smoke) {
   char* p = nullptr;
   ASSERT_EQ(11, asprintf(&p, "hello %s", "world"));
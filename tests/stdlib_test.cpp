@@ -610,6 +610,70 @@ TEST(stdlib, strtod_largest_subnormal) {
   ASSERT_EQ(-2.2250738585072014e-308, strtod("-2.2250738585072012e-308", nullptr));
 }
 
+TEST(stdlib, strtod_round_trip) {
+  // Check values on both sides of the fast path's limits (19 significant digits,
+  // exact halfway cases, and the ends of the double range) round-trip exactly.
+  const double values[] = {
+      0.1,    0.3,       1.0 / 3.0, 123456789012345678.0, 9007199254740993.0, 7.2057594037927933e16,
+      1e23,   5e-324,    2.2250738585072014e-308, 1.7976931348623157e308, 1e-300, 6.02214076e23,
+  };
+  for (double value : values) {
+    char buf[64];
+    for (int precision = 15; precision <= 25; ++precision) {
+      snprintf(buf, sizeof(buf), "%.*g", precision, value);
+      char* end;
+      double result = strtod(buf, &end);
+      ASSERT_EQ(buf + strlen(buf), end) << buf;
+      if (precision >= 17) ASSERT_EQ(value, result) << buf;
+    }
+  }
+
+  // The correctly rounded results are on either side of exact halfway points.
+  ASSERT_EQ(9007199254740992.0, strtod("9007199254740993", nullptr));
+  ASSERT_EQ(9007199254740994.0, strtod("9007199254740993.0000000001", nullptr));
+  ASSERT_EQ(16777216.0f, strtof("16777217", nullptr));
+  ASSERT_EQ(16777218.0f, strtof("16777217.000001", nullptr));
+  ASSERT_EQ(0.1f, strtof("0.1", nullptr));
+  ASSERT_EQ(3.4028235e38f, strtof("3.4028235e38", nullptr));
+}
+
+TEST(stdlib, strtod_end_ptr) {
+  char* p;
+  ASSERT_EQ(12.5, strtod("12.5e", &p));
+  ASSERT_STREQ("e", p);
+  ASSERT_EQ(12.5, strtod("12.5e+", &p));
+  ASSERT_STREQ("e+", p);
+  ASSERT_EQ(1250.0, strtod("12.5e2x", &p));
+  ASSERT_STREQ("x", p);
+  ASSERT_EQ(5.0, strtod("5.", &p));
+  ASSERT_STREQ("", p);
+  ASSERT_EQ(0.5, strtod(".5", &p));
+  ASSERT_STREQ("", p);
+  ASSERT_EQ(0.0, strtod(".", &p));
+  ASSERT_STREQ(".", p);
+  ASSERT_EQ(0.0, strtod("- 1", &p));
+  ASSERT_STREQ("- 1", p);
+  ASSERT_EQ(0.0, strtod("00x1", &p));
+  ASSERT_STREQ("x1", p);
+  ASSERT_TRUE(signbit(strtod("-0.0e10", &p)));
+  ASSERT_STREQ("", p);
+}
+
+TEST(stdlib, strtod_range_errors) {
+  errno = 0;
+  ASSERT_EQ(HUGE_VAL, strtod("1e309", nullptr));
+  ASSERT_ERRNO(ERANGE);
+  errno = 0;
+  ASSERT_EQ(-HUGE_VALF, strtof("-1e39", nullptr));
+  ASSERT_ERRNO(ERANGE);
+  errno = 0;
+  ASSERT_EQ(0.0, strtod("1e-400", nullptr));
+  ASSERT_ERRNO(ERANGE);
+  errno = 0;
+  ASSERT_EQ(0.0, strtod("0e-400", nullptr));
+  ASSERT_ERRNO(0);
+}
+
 TEST(stdlib, quick_exit) {
   pid_t pid = fork();
   ASSERT_NE(-1, pid) << strerror(errno);
@@ -923,6 +987,33 @@ static void CheckStrToInt(T fn(const char* s, char** end, int base)) {
       ASSERT_ERRNO(ERANGE);
       ASSERT_STREQ("abc", end_p);
   }
+
+  // Leading zeros don't count towards overflow.
+  std::string zeros(64, '0');
+  end_p = nullptr;
+  errno = 0;
+  ASSERT_EQ(static_cast<T>(1234567890), fn((zeros + "1234567890x").c_str(), &end_p, 10));
+  ASSERT_ERRNO(0);
+  ASSERT_STREQ("x", end_p);
+  end_p = nullptr;
+  ASSERT_EQ(static_cast<T>(0x7fffabcd), fn(("0x" + zeros + "7fffABCDx").c_str(), &end_p, 16));
+  ASSERT_ERRNO(0);
+  ASSERT_STREQ("x", end_p);
+
+  // Maximum in hex, and one digit too many.
+  char hex_max[32];
+  snprintf(hex_max, sizeof(hex_max), "0x%llx",
+           static_cast<unsigned long long>(std::numeric_limits<T>::max()));
+  end_p = nullptr;
+  errno = 0;
+  ASSERT_EQ(std::numeric_limits<T>::max(), fn(hex_max, &end_p, 16));
+  ASSERT_ERRNO(0);
+  ASSERT_EQ('\0', *end_p);
+  strcat(hex_max, "0");
+  end_p = nullptr;
+  ASSERT_EQ(std::numeric_limits<T>::max(), fn(hex_max, &end_p, 16));
+  ASSERT_ERRNO(ERANGE);
+  ASSERT_EQ('\0', *end_p);
 }
 
 TEST(stdlib, strtol_smoke) {
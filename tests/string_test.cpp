@@ -1619,6 +1619,108 @@ TEST(STRING_TEST, strcasestr_smoke) {
   ASSERT_EQ(haystack + 4, strcasestr(haystack, "Da"));
 }
 
+TEST(STRING_TEST, memmem_strstr_strcasestr_long) {
+  // A haystack of 'a's and a needle of "aa...ab" makes every position look
+  // like a possible match, which is the worst case for a search that only
+  // checks the first and last bytes before comparing the whole needle.
+  std::vector<char> haystack(64 * KB + 7, 'a');
+  haystack.back() = '\0';
+  const size_t haystack_size = haystack.size() - 1;
+  std::vector<char> needle(100, 'a');
+  needle[98] = 'b';
+  needle[99] = '\0';
+  const size_t needle_size = needle.size() - 1;
+
+  ASSERT_EQ(nullptr, memmem(haystack.data(), haystack_size, needle.data(), needle_size));
+  ASSERT_EQ(nullptr, strstr(haystack.data(), needle.data()));
+  ASSERT_EQ(nullptr, strcasestr(haystack.data(), needle.data()));
+
+  // Matches either side of vector and window boundaries.
+  const size_t positions[] = {0,   1,    15,   16,   31,      32, 63, 64, 255,
+                              256, 1000, 4095, 4096, 32 * KB, haystack_size - needle_size};
+  for (size_t pos : positions) {
+    std::vector<char> copy(haystack);
+    memcpy(copy.data() + pos, needle.data(), needle_size);
+    ASSERT_EQ(copy.data() + pos, memmem(copy.data(), haystack_size, needle.data(), needle_size))
+        << pos;
+    ASSERT_EQ(copy.data() + pos, strstr(copy.data(), needle.data())) << pos;
+    copy[pos] = 'A';
+    copy[pos + needle_size - 1] = 'B';
+    ASSERT_EQ(copy.data() + pos, strcasestr(copy.data(), needle.data())) << pos;
+  }
+}
+
+TEST(STRING_TEST, strspn_smoke) {
+  ASSERT_EQ(0U, strspn("", ""));
+  ASSERT_EQ(0U, strspn("", "abc"));
+  ASSERT_EQ(0U, strspn("abc", ""));
+  ASSERT_EQ(3U, strspn("aaab", "a"));
+  ASSERT_EQ(6U, strspn("abcabcd", "cba"));
+  ASSERT_EQ(2U, strspn(" \tGET", "\t "));
+  ASSERT_EQ(2U, strspn("\x80\xff\x7f", "\xff\x80"));
+}
+
+TEST(STRING_TEST, strcspn_smoke) {
+  ASSERT_EQ(0U, strcspn("", ""));
+  ASSERT_EQ(3U, strcspn("abc", ""));
+  ASSERT_EQ(3U, strcspn("abc", "x"));
+  ASSERT_EQ(1U, strcspn("abc", "b"));
+  ASSERT_EQ(4U, strcspn("Host: example.com\r\n", ":\r\n"));
+  ASSERT_EQ(1U, strcspn("\x7f\x80\xff", "\xff\x80"));
+}
+
+TEST(STRING_TEST, strpbrk_smoke) {
+  const char* s = "key=value; other";
+  ASSERT_EQ(nullptr, strpbrk(s, ""));
+  ASSERT_EQ(nullptr, strpbrk(s, "!?"));
+  ASSERT_EQ(s + 3, strpbrk(s, "=;"));
+  ASSERT_EQ(s + 9, strpbrk(s, "; "));
+  ASSERT_EQ(s + 15, strpbrk(s, "r"));
+}
+
+TEST(STRING_TEST, strspn_strcspn_strpbrk_alignment) {
+  // Check every alignment of the start and end of the span, across more than
+  // one vector.
+  char buf[256];
+  for (size_t start = 0; start < 64; ++start) {
+    for (size_t len = 0; len < 128; ++len) {
+      memset(buf, 'x', sizeof(buf));
+      memset(buf + start, 'a', len);
+      buf[start + len] = 'b';
+      buf[start + len + 1] = '\0';
+      ASSERT_EQ(len, strspn(buf + start, "a\x80")) << start << " " << len;
+      ASSERT_EQ(len, strcspn(buf + start, "b\xff")) << start << " " << len;
+      ASSERT_EQ(buf + start + len, strpbrk(buf + start, "b\xff")) << start << " " << len;
+      buf[start + len] = '\0';
+      ASSERT_EQ(len, strcspn(buf + start, "bc")) << start << " " << len;
+      ASSERT_EQ(nullptr, strpbrk(buf + start, "bc")) << start << " " << len;
+    }
+  }
+}
+
+TEST(STRING_TEST, strcasestr_long_mixed_case) {
+  // Like memmem_strstr_strcasestr_long, but with the case of the haystack and
+  // needle mixed up, so the case-folding Two-Way fallback has to do the folding.
+  std::vector<char> haystack(64 * KB + 7);
+  for (size_t i = 0; i < haystack.size(); ++i) haystack[i] = (i % 3 == 0) ? 'A' : 'a';
+  haystack.back() = '\0';
+  const size_t haystack_size = haystack.size() - 1;
+  std::vector<char> needle(100);
+  for (size_t i = 0; i < needle.size(); ++i) needle[i] = (i % 2 == 0) ? 'a' : 'A';
+  needle[98] = 'b';
+  needle[99] = '\0';
+  const size_t needle_size = needle.size() - 1;
+
+  ASSERT_EQ(nullptr, strcasestr(haystack.data(), needle.data()));
+
+  const size_t positions[] = {0, 1, 4095, 4096, 32 * KB, haystack_size - needle_size};
+  for (size_t pos : positions) {
+    std::vector<char> copy(haystack);
+    copy[pos + needle_size - 1] = 'B';
+    ASSERT_EQ(copy.data() + pos, strcasestr(copy.data(), needle.data())) << pos;
+  }
+}
+
 TEST(STRING_TEST, strcoll_smoke) {
   ASSERT_TRUE(strcoll("aab", "aac") < 0);
   ASSERT_TRUE(strcoll("aab", "aab") == 0);
@@ -20,6 +20,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <string>
 #include <thread>
 
@@ -326,6 +327,41 @@ TEST(properties, __system_property_find_nth) {
 #endif // __BIONIC__
 }
 
+TEST(properties, find_repeated) {
+#if defined(__BIONIC__)
+    SystemPropertiesTest system_properties;
+    ASSERT_TRUE(system_properties.valid());
+
+    // Failed lookups mustn't be remembered.
+    ASSERT_TRUE(system_properties.Find("property") == nullptr);
+    ASSERT_EQ(0, system_properties.Add("property", 8, "value1", 6));
+    const prop_info* pi = system_properties.Find("property");
+    ASSERT_TRUE(pi != nullptr);
+    ASSERT_EQ(pi, system_properties.Find("property"));
+
+    // Use more names than fit in the find cache, so some collide.
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+    for (int i = 0; i < 512; i++) {
+      snprintf(name, sizeof(name), "property.%d", i);
+      snprintf(value, sizeof(value), "value.%d", i);
+      ASSERT_EQ(0, system_properties.Add(name, strlen(name), value, strlen(value)));
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      for (int i = 0; i < 512; i++) {
+        char expected[PROP_VALUE_MAX];
+        snprintf(name, sizeof(name), "property.%d", i);
+        snprintf(expected, sizeof(expected), "value.%d", i);
+        ASSERT_EQ(static_cast<int>(strlen(expected)), system_properties.Get(name, value));
+        ASSERT_STREQ(expected, value);
+      }
+    }
+    ASSERT_EQ(pi, system_properties.Find("property"));
+#else // __BIONIC__
+    GTEST_SKIP() << "bionic-only test";
+#endif // __BIONIC__
+}
+
 TEST(properties, fill_hierarchical) {
 #if defined(__BIONIC__)
     SystemPropertiesTest system_properties;
@@ -486,6 +522,160 @@ TEST(properties, __system_property_wait) {
 #endif // __BIONIC__
 }
 
+TEST(properties, read_batch) {
+#if defined(__BIONIC__)
+    SystemPropertiesTest system_properties;
+    ASSERT_TRUE(system_properties.valid());
+
+    ASSERT_EQ(0, system_properties.Add("property1", 9, "value1", 6));
+    ASSERT_EQ(0, system_properties.Add("property2", 9, "value2", 6));
+    ASSERT_EQ(0, system_properties.Add("property3", 9, "value3", 6));
+
+    const prop_info* pis[3] = {
+        system_properties.Find("property1"),
+        system_properties.Find("property2"),
+        system_properties.Find("property3"),
+    };
+    char values[3][PROP_VALUE_MAX];
+    uint32_t serials[3];
+    ASSERT_EQ(0, system_properties.ReadBatch(pis, 3, values, serials));
+    ASSERT_STREQ("value1", values[0]);
+    ASSERT_STREQ("value2", values[1]);
+    ASSERT_STREQ("value3", values[2]);
+    for (size_t i = 0; i < 3; ++i) {
+      ASSERT_EQ(__system_property_serial(pis[i]), serials[i]);
+    }
+
+    // A writer that always keeps the three values equal; every snapshot must agree.
+    std::atomic<bool> done = false;
+    std::thread thread([&system_properties, &pis, &done]() {
+      char value[PROP_VALUE_MAX];
+      for (int i = 0; i < 1000; ++i) {
+        snprintf(value, sizeof(value), "%d", i);
+        for (const prop_info* pi : pis) {
+          system_properties.Update(const_cast<prop_info*>(pi), value, strlen(value));
+        }
+      }
+      done = true;
+    });
+    while (!done) {
+      ASSERT_EQ(0, system_properties.ReadBatch(pis, 3, values, nullptr));
+      // Updates happen in order, so a consistent snapshot sees some prefix of the
+      // properties with the newer value and the rest with the older one.
+      long v0 = strtol(values[0], nullptr, 10);
+      long v1 = strtol(values[1], nullptr, 10);
+      long v2 = strtol(values[2], nullptr, 10);
+      ASSERT_GE(v0, v1);
+      ASSERT_GE(v1, v2);
+      ASSERT_LE(v0 - v2, 1);
+    }
+    thread.join();
+#else // __BIONIC__
+    GTEST_SKIP() << "bionic-only test";
+#endif // __BIONIC__
+}
+
+TEST(properties, wait_multiple) {
+#if defined(__BIONIC__)
+    SystemPropertiesTest system_properties;
+    ASSERT_TRUE(system_properties.valid());
+
+    ASSERT_EQ(0, system_properties.Add("watched1", 8, "value1", 6));
+    ASSERT_EQ(0, system_properties.Add("watched2", 8, "value2", 6));
+    ASSERT_EQ(0, system_properties.Add("other", 5, "value3", 6));
+
+    const prop_info* pis[2] = {
+        system_properties.Find("watched1"),
+        system_properties.Find("watched2"),
+    };
+    uint32_t old_serials[2] = {__system_property_serial(pis[0]), __system_property_serial(pis[1])};
+    uint32_t new_serials[2];
+
+    // Nothing changes, so we time out.
+    timespec timeout = {.tv_sec = 0, .tv_nsec = 100'000'000};
+    ASSERT_FALSE(system_properties.WaitMultiple(pis, old_serials, 2, new_serials, &timeout));
+
+    // A stale serial returns straight away.
+    uint32_t stale_serials[2] = {old_serials[0], old_serials[1] - 1};
+    ASSERT_TRUE(system_properties.WaitMultiple(pis, stale_serials, 2, new_serials, nullptr));
+    ASSERT_EQ(old_serials[1], new_serials[1]);
+
+    // Updates to unwatched properties don't end the wait; updates to watched ones do.
+    std::atomic<int> step = 0;
+    std::thread thread([&system_properties, &step]() {
+      usleep(100000);
+      system_properties.Update(const_cast<prop_info*>(system_properties.Find("other")), "x", 1);
+      usleep(100000);
+      step = 1;
+      system_properties.Update(const_cast<prop_info*>(system_properties.Find("watched2")), "y", 1);
+    });
+    ASSERT_TRUE(system_properties.WaitMultiple(pis, old_serials, 2, new_serials, nullptr));
+    ASSERT_EQ(1, step);
+    ASSERT_EQ(old_serials[0], new_serials[0]);
+    ASSERT_NE(old_serials[1], new_serials[1]);
+    thread.join();
+
+    // Bad counts are rejected.
+    ASSERT_FALSE(system_properties.WaitMultiple(pis, old_serials, 0, new_serials, nullptr));
+#else // __BIONIC__
+    GTEST_SKIP() << "bionic-only test";
+#endif // __BIONIC__
+}
+
+TEST(properties, foreach_context) {
+#if defined(__BIONIC__)
+    SystemPropertiesTest system_properties;
+    ASSERT_TRUE(system_properties.valid());
+
+    struct totals {
+      size_t contexts;
+      size_t mapped;
+      uint64_t lookups;
+      uint64_t bytes_used;
+    };
+    auto count = [](const prop_context_stats* stats, void* cookie) {
+      auto* t = static_cast<totals*>(cookie);
+      ASSERT_TRUE(stats->context != nullptr);
+      t->contexts++;
+      if (stats->mapped_size != 0) {
+        t->mapped++;
+        ASSERT_GE(stats->map_count, 1U);
+        ASSERT_GT(stats->bytes_used, 0U);
+        ASSERT_LE(stats->bytes_used, stats->bytes_total);
+        ASSERT_LT(stats->bytes_total, stats->mapped_size);
+      }
+      t->lookups += stats->lookup_count;
+      t->bytes_used += stats->bytes_used;
+    };
+
+    totals before = {};
+    ASSERT_EQ(0, system_properties.ForeachContext(count, &before));
+    ASSERT_GT(before.contexts, 0U);
+    // The property service maps every area up front.
+    ASSERT_EQ(before.contexts, before.mapped);
+
+    ASSERT_EQ(0, system_properties.Add("property", 8, "value", 5));
+    ASSERT_TRUE(system_properties.Find("property") != nullptr);
+    ASSERT_TRUE(system_properties.Find("no_such_property") == nullptr);
+
+    totals after = {};
+    ASSERT_EQ(0, system_properties.ForeachContext(count, &after));
+    ASSERT_EQ(before.contexts, after.contexts);
+    ASSERT_GE(after.lookups, before.lookups + 3);
+    ASSERT_GT(after.bytes_used, before.bytes_used);
+
+    // Lookups answered from the cache count too.
+    for (size_t i = 0; i < 10; ++i) {
+      ASSERT_TRUE(system_properties.Find("property") != nullptr);
+    }
+    totals cached = {};
+    ASSERT_EQ(0, system_properties.ForeachContext(count, &cached));
+    ASSERT_GE(cached.lookups, after.lookups + 10);
+#else // __BIONIC__
+    GTEST_SKIP() << "bionic-only test";
+#endif // __BIONIC__
+}
+
 class KilledByFault {
     public:
         explicit KilledByFault() {};
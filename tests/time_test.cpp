@@ -29,6 +29,7 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include "SignalUtils.h"
 #include "utils.h"
@@ -401,6 +402,41 @@ TEST(time, strftime_z_Europe_Lisbon) {
   EXPECT_STREQ("+0000", str);
 }
 
+TEST(time, strftime_repeated_formats) {
+  setenv("TZ", "UTC", 1);
+
+  // Bionic keeps a parsed copy of the first few formats it sees, so check
+  // that reusing a format (and running out of room for more) gives the same
+  // results, including when the output is truncated.
+  struct tm tm = {.tm_sec = 5, .tm_min = 4, .tm_hour = 3, .tm_mday = 2, .tm_mon = 0,
+                  .tm_year = 2001 - 1900, .tm_wday = 2, .tm_yday = 1};
+  const std::pair<const char*, const char*> cases[] = {
+      {"%Y-%m-%d %H:%M:%S", "2001-01-02 03:04:05"},
+      {"%F %T", "2001-01-02 03:04:05"},
+      {"%d/%b/%Y:%H:%M:%S %z", "02/Jan/2001:03:04:05 +0000"},
+      {"%_d %-m %e %k %l %j %y %C", " 2 1  2  3  3 002 01 20"},
+      {"%a %A %^b %^B %p %P %Z", "Tue Tuesday JAN JANUARY AM am UTC"},
+      {"%D %R %r", "01/02/01 03:04 03:04:05 AM"},
+      {"%U %W %V %G %u %w", "00 01 01 2001 2 2"},
+      {"%c", "Tue Jan  2 03:04:05 2001"},
+      {"%x %X %%", "01/02/01 03:04:05 %"},
+      {"[%H]", "[03]"},
+  };
+  char buf[64];
+  for (size_t pass = 0; pass < 3; ++pass) {
+    for (const auto& [format, expected] : cases) {
+      EXPECT_EQ(strlen(expected), strftime(buf, sizeof(buf), format, &tm)) << format;
+      EXPECT_STREQ(expected, buf) << format;
+
+      errno = 0;
+      EXPECT_EQ(0U, strftime(buf, strlen(expected), format, &tm)) << format;
+#if defined(__BIONIC__)
+      EXPECT_ERRNO(ERANGE);
+#endif
+    }
+  }
+}
+
 TEST(time, strftime_l) {
   locale_t cloc = newlocale(LC_ALL, "C.UTF-8", nullptr);
   locale_t old_locale = uselocale(cloc);
@@ -1191,6 +1227,59 @@ TEST(time, bug_31339449) {
 #endif
 }
 
+TEST(time, localtime_r_TZ_changes) {
+  // localtime_r and mktime don't take a lock unless the zone they used last
+  // time has changed, so check that they notice when it does, and that
+  // tzname keeps up, even when going back to a zone used before. There are
+  // more zones here than bionic keeps loaded, so some have to be reloaded.
+#if !defined(__BIONIC__)
+  GTEST_SKIP() << "glibc's localtime_r doesn't notice TZ changes (see bug_31339449)";
+#endif
+  time_t t = 1475619727;
+  const std::pair<const char*, int> zones[] = {
+      {"America/Los_Angeles", 15}, {"Europe/London", 23}, {"Asia/Seoul", 7},
+      {"UTC", 22},                 {"Asia/Tokyo", 7},     {"Asia/Kolkata", 3},
+      {"Europe/Berlin", 0},        {"America/New_York", 18}, {"Australia/Sydney", 9},
+      {"Asia/Dubai", 2},           {"America/Chicago", 17},
+  };
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (const auto& [name, hour] : zones) {
+      setenv("TZ", name, 1);
+      struct tm tm = {};
+      ASSERT_TRUE(localtime_r(&t, &tm) != nullptr);
+      EXPECT_EQ(hour, tm.tm_hour) << name;
+      EXPECT_EQ(t, mktime(&tm)) << name;
+      EXPECT_STREQ(tm.tm_zone, tzname[tm.tm_isdst]) << name;
+    }
+  }
+}
+
+TEST(time, localtime_r_threads) {
+  setenv("TZ", "America/Los_Angeles", 1);
+  tzset();
+
+  // Every thread converts the same hours, across several DST transitions.
+  auto fn = []() {
+    for (time_t t = 1475619727; t < 1475619727 + 2 * 365 * 86400; t += 3600) {
+      struct tm tm = {};
+      if (localtime_r(&t, &tm) == nullptr || tm.tm_gmtoff != (tm.tm_isdst ? -7 : -8) * 3600 ||
+          mktime(&tm) != t) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::vector<std::thread> threads;
+  std::atomic<int> failures = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      if (!fn()) ++failures;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  ASSERT_EQ(0, failures);
+}
+
 TEST(time, asctime) {
   const struct tm tm = {};
   ASSERT_STREQ("Sun Jan  0 00:00:00 1900\n", asctime(&tm));
@@ -1452,6 +1541,39 @@ TEST(time, tzalloc_nullptr) {
 #endif
 }
 
+TEST(time, tzalloc_many_zones) {
+#if defined(__BIONIC__)
+  // More zones than tzalloc() caches, in an order that has it evict some
+  // zones and reuse others, with the expected results for mktime_z() at
+  // midnight on 1993-01-01 local time.
+  const std::pair<const char*, time_t> zones[] = {
+      {"Asia/Seoul", 725814000},         {"Europe/London", 725846400},
+      {"America/Los_Angeles", 725875200}, {"America/New_York", 725864400},
+      {"Asia/Kolkata", 725826600},        {"Australia/Sydney", 725806800},
+      {"Europe/Paris", 725842800},        {"Asia/Tokyo", 725814000},
+      {"UTC", 725846400},                 {"Africa/Nairobi", 725835600},
+  };
+  for (size_t pass = 0; pass < 3; ++pass) {
+    for (const auto& [name, expected] : zones) {
+      timezone_t tz = tzalloc(name);
+      ASSERT_NE(nullptr, tz) << name;
+      struct tm tm = {.tm_year = 93, .tm_mday = 1};
+      EXPECT_EQ(expected, mktime_z(tz, &tm)) << name;
+      tzfree(tz);
+    }
+  }
+
+  errno = 0;
+  ASSERT_EQ(nullptr, tzalloc("Mars/Olympus_Mons"));
+  ASSERT_ERRNO(ENOENT);
+  errno = 0;
+  ASSERT_EQ(nullptr, tzalloc("Mars/Olympus_Mons"));
+  ASSERT_ERRNO(ENOENT);
+#else
+  GTEST_SKIP() << "glibc doesn't have timezone_t";
+#endif
+}
+
 TEST(time, tzalloc_unique_ptr) {
 #if defined(__BIONIC__)
   std::unique_ptr<std::remove_pointer_t<timezone_t>, decltype(&tzfree)> tz{tzalloc("Asia/Seoul"),
@@ -1186,6 +1186,51 @@ TEST(wchar, wcscasecmp) {
   ASSERT_TRUE(wcscasecmp(L"hell", L"HELLO") < 0);
 }
 
+TEST(wchar, wcscmp) {
+  ASSERT_EQ(0, wcscmp(L"", L""));
+  ASSERT_EQ(0, wcscmp(L"hello", L"hello"));
+  ASSERT_LT(wcscmp(L"hello1", L"hello2"), 0);
+  ASSERT_GT(wcscmp(L"hello2", L"hello1"), 0);
+  ASSERT_GT(wcscmp(L"hello", L"hell"), 0);
+  ASSERT_LT(wcscmp(L"hell", L"hello"), 0);
+}
+
+TEST(wchar, wcscmp_large_difference) {
+#if defined(__BIONIC__)
+  // bionic compares characters as unsigned values on every architecture,
+  // whichever implementation is in use, so the sign mustn't depend on
+  // whether the difference fits in an int. Try the differing character at
+  // every offset of a string longer than a vector register, with every
+  // alignment.
+  const wchar_t big = static_cast<wchar_t>(0xffffffff);
+  const wchar_t mid = static_cast<wchar_t>(0x80000000);
+  for (size_t align = 0; align < 8; ++align) {
+    for (size_t i = 0; i < 40; ++i) {
+      wchar_t s1[64];
+      wchar_t s2[64];
+      wmemset(s1, L'x', 63);
+      wmemset(s2 + align, L'x', 63 - align);
+      s1[i + 1] = s2[align + i + 1] = L'\0';
+
+      s1[i] = big;
+      s2[align + i] = 1;
+      ASSERT_GT(wcscmp(s1, s2 + align), 0) << align << " " << i;
+      ASSERT_LT(wcscmp(s2 + align, s1), 0) << align << " " << i;
+
+      s1[i] = mid;
+      ASSERT_GT(wcscmp(s1, s2 + align), 0) << align << " " << i;
+      ASSERT_LT(wcscmp(s2 + align, s1), 0) << align << " " << i;
+
+      s2[align + i] = big;
+      ASSERT_LT(wcscmp(s1, s2 + align), 0) << align << " " << i;
+      ASSERT_GT(wcscmp(s2 + align, s1), 0) << align << " " << i;
+    }
+  }
+#else
+  GTEST_SKIP() << "glibc compares wchar_t as signed on x86_64";
+#endif
+}
+
 TEST(wchar, wcscspn) {
   ASSERT_EQ(0U, wcscspn(L"hello world", L"abcdefghijklmnopqrstuvwxyz"));
   ASSERT_EQ(5U, wcscspn(L"hello world", L" "));